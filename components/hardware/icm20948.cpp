@@ -182,3 +182,21 @@ bool ICM20948::readMag(Vec3i& data) {
 
     return true;
 }
+
+/**
+ * @brief 使能数据就绪中断，每次陀螺仪和加速度计寄存器更新时INT引脚输出约50us的高电平脉冲
+ * 
+ * @note 需在init之后调用，采样率由init的分频参数决定（默认1125Hz）；
+ *       主机在上升沿记录时间戳，即为该组数据的采样时刻
+ */
+bool ICM20948::enableDataReady() {
+    if (!success) return false;
+    if (!selUserBank(USER_BANK_0)) return false;
+
+    uint8_t INT_PIN_CFG_DATA;
+    if (!i2c.read_bytes_from_mem(ICM20948_ADDR, INT_PIN_CFG, &INT_PIN_CFG_DATA, 1)) return false;
+    INT_PIN_CFG_DATA &= ~0xE0; // 高电平有效、推挽输出、不锁存（脉冲），保留旁路模式设置
+    if (!i2c.write_byte_to_mem(ICM20948_ADDR, INT_PIN_CFG, INT_PIN_CFG_DATA)) return false;
+
+    return i2c.write_byte_to_mem(ICM20948_ADDR, INT_ENABLE_1, 0x01); // RAW_DATA_0_RDY_EN
+}
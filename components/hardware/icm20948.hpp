@@ -35,6 +35,7 @@ class ICM20948 {
         bool readGyro(Vec3i& data); // 读陀螺仪
         bool readAccel(Vec3i& data); // 读加速度计
         bool readMag(Vec3i& data);   // 读磁力计
+        bool enableDataReady(); // 在INT引脚上输出数据就绪脉冲
 
     private:
         static constexpr const char* TAG = "ICM20948"; // 日志标签
@@ -60,6 +61,7 @@ class ICM20948 {
             WHO_AM_I             = 0x00, // 设备识别寄存器
             USER_CTRL            = 0x03, // 用与控制传感器的主要功能
             INT_PIN_CFG          = 0x0F, // 中断引脚配置
+            INT_ENABLE_1         = 0x11, // 数据就绪中断使能
             EXT_SLV_SENS_DATA_00 = 0x3B, // 在配置好 I2C 主机读取操作后，磁力计的数据将被存放在这些寄存器中
             GYRO_XOUT_H          = 0x33, // 陀螺仪X轴高位地址，到0x38为连续的6位数据位
             ACCEL_XOUT_H         = 0x2D, // 加速度计X轴高位地址
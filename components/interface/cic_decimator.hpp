@@ -0,0 +1,102 @@
+#ifndef CIC_DECIMATOR_HPP
+#define CIC_DECIMATOR_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief 整数CIC抽取滤波器，每ratio个输入输出一个均值，只用加减法和每次输出一次除法
+ *
+ * @param ORDER 级数，1即每ratio个采样求一次平均（抽取的滑动平均），级数越高阻带衰减越大
+ *
+ * @note 积分器按uint32_t模运算自然回绕，只要 输入最大值 * ratio^ORDER 不超过32位，
+ *       梳状级相减后的结果就是正确的；12位ADC在ORDER为2时ratio最大1024。
+ *       启动后前ORDER-1个输出未填满，丢弃不输出
+ */
+template <unsigned ORDER = 2>
+class CicDecimator {
+    static_assert(ORDER >= 1 && ORDER <= 4, "CIC order must be 1..4");
+
+    public:
+        // 抽取比超出32位范围时退化为1，即不抽取
+        explicit CicDecimator(uint32_t ratio = 16, uint32_t maxInput = 4095) {
+            reset();
+            setRatio(ratio, maxInput);
+        }
+
+        /**
+         * @brief 设置抽取比并清空状态
+         *
+         * @param ratio 抽取比
+         * @param maxInput 输入最大值，用于检查32位是否够用
+         *
+         * @return 增益超出32位时返回false，保持原抽取比
+         */
+        bool setRatio(uint32_t ratio, uint32_t maxInput = 4095) {
+            if (!ratio) return false;
+            uint64_t gain = 1;
+            for (unsigned i = 0; i < ORDER; i++) gain *= ratio;
+            if (gain * (maxInput ? maxInput : 1) > UINT32_MAX) return false;
+            m_ratio = ratio;
+            m_gain = (uint32_t)gain;
+            reset();
+            return true;
+        }
+
+        void reset() {
+            for (unsigned i = 0; i < ORDER; i++) m_integ[i] = m_comb[i] = 0;
+            m_phase = 0;
+            m_warm = 0;
+        }
+
+        // 压入一个采样，凑满ratio个时输出四舍五入的均值并返回true
+        bool push(uint32_t x, uint32_t& out) {
+            m_integ[0] += x;
+            for (unsigned i = 1; i < ORDER; i++) m_integ[i] += m_integ[i - 1];
+            if (++m_phase < m_ratio) return false;
+            m_phase = 0;
+
+            uint32_t v = m_integ[ORDER - 1];
+            for (unsigned i = 0; i < ORDER; i++) {
+                uint32_t d = v - m_comb[i];
+                m_comb[i] = v;
+                v = d;
+            }
+            if (m_warm < ORDER - 1) {
+                m_warm++;
+                return false;
+            }
+            out = (uint32_t)(((uint64_t)v + m_gain / 2) / m_gain);
+            return true;
+        }
+
+        /**
+         * @brief 处理一批采样，每个输出调用一次emit(uint32_t)
+         *
+         * @return 输出的个数
+         */
+        template <class T, class Fn>
+        size_t process(const T* in, size_t n, Fn&& emit) {
+            size_t outputs = 0;
+            uint32_t out;
+            for (size_t i = 0; i < n; i++) {
+                if (push(in[i], out)) {
+                    emit(out);
+                    outputs++;
+                }
+            }
+            return outputs;
+        }
+
+        uint32_t ratio() const { return m_ratio; }
+
+    private:
+        uint32_t m_integ[ORDER]; // 积分级
+        uint32_t m_comb[ORDER]; // 梳状级的上一次输入
+        uint32_t m_ratio = 1;
+        uint32_t m_gain = 1; // ratio^ORDER
+        uint32_t m_phase; // 当前抽取周期内已压入的采样数
+        unsigned m_warm; // 已丢弃的未填满输出数
+};
+
+#endif
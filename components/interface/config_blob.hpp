@@ -0,0 +1,161 @@
+#ifndef CONFIG_BLOB_HPP
+#define CONFIG_BLOB_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "struct.hpp"
+
+/**
+ * 只读配置区格式，由 tools/config_gen.py 生成，烧录到config分区后经mmap直接以const结构体访问：
+ * | ConfigHead | ConfigEntry × count | 表数据（各自按8字节对齐） |
+ * 所有字段小端，crc为ConfigHead之后到size为止的CRC-32，只在映射时校验一次。
+ * 表结构体变动时递增其版本号并同步修改生成工具中的格式串，版本不符的表查不到
+ */
+#define CONFIG_MAGIC 0x42474643 // "CFGB"
+#define CONFIG_FORMAT 1 // 配置区格式版本
+
+// 配置区头
+struct ConfigHead
+{
+    uint32_t magic = CONFIG_MAGIC;
+    uint16_t format = CONFIG_FORMAT; // 格式版本
+    uint16_t count = 0; // 表数
+    uint32_t size = 0; // 配置区总长度，含头
+    uint32_t crc = 0; // 头之后全部内容的CRC-32
+}__attribute__((packed)); // 不进行字节对齐
+
+// 表目录项
+struct ConfigEntry
+{
+    uint16_t id = 0; // 表ID，见CONFIG_ID
+    uint16_t version = 0; // 表结构体版本
+    uint32_t offset = 0; // 数据相对配置区起始的偏移，8字节对齐
+    uint32_t len = 0; // 数据长度
+}__attribute__((packed)); // 不进行字节对齐
+
+// 表ID，新增表在此分配
+enum CONFIG_ID : uint16_t {
+    CFG_IMU_CALI  = 1, // 出厂IMU校准，ImuCali，版本为IMU_CALI_VERSION
+    CFG_GYRO_TEMP = 2, // 陀螺仪零偏随温度变化的曲线，GyroTempCurve
+    CFG_FILTER    = 3, // 二阶节滤波器系数，BiquadCoeffs
+};
+
+/**
+ * @brief 陀螺仪零偏-温度曲线，分段线性，温度升序
+ */
+#define GYRO_TEMP_VERSION 1
+struct GyroTempCurve
+{
+    static constexpr size_t MAX_POINTS = 8; // 最多的标定点数
+
+    uint32_t count = 0; // 有效标定点数
+    uint32_t reserved = 0;
+    float temp[MAX_POINTS] = {}; // 标定温度（℃）
+    float bias[MAX_POINTS][3] = {}; // 对应的陀螺仪零偏（°/s）
+
+    // 按温度插值零偏，超出标定范围时取端点
+    Vec3lf at(float t) const {
+        Vec3lf out;
+        if (!count) return out;
+        size_t i = 0;
+        while (i + 1 < count && temp[i + 1] < t) i++;
+        float k = 0.0f;
+        if (i + 1 < count && t > temp[i]) k = (t - temp[i]) / (temp[i + 1] - temp[i]);
+        size_t j = i + 1 < count ? i + 1 : i;
+        out.x = bias[i][0] + (bias[j][0] - bias[i][0]) * k;
+        out.y = bias[i][1] + (bias[j][1] - bias[i][1]) * k;
+        out.z = bias[i][2] + (bias[j][2] - bias[i][2]) * k;
+        return out;
+    }
+};
+
+/**
+ * @brief 级联二阶节滤波器系数，每节为 b0 b1 b2 a1 a2（a0归一化为1）
+ */
+#define BIQUAD_VERSION 1
+struct BiquadCoeffs
+{
+    static constexpr size_t MAX_SECTIONS = 4; // 最多的节数
+
+    uint32_t count = 0; // 有效节数
+    uint32_t reserved = 0;
+    float sos[MAX_SECTIONS][5] = {};
+};
+
+// 布局与 tools/config_gen.py 的格式串一致
+static_assert(sizeof(ConfigHead) == 16, "ConfigHead layout");
+static_assert(sizeof(ConfigEntry) == 12, "ConfigEntry layout");
+static_assert(sizeof(ImuCali) == 64, "ImuCali layout");
+static_assert(sizeof(GyroTempCurve) == 136, "GyroTempCurve layout");
+static_assert(sizeof(BiquadCoeffs) == 88, "BiquadCoeffs layout");
+
+/**
+ * @brief 配置区的只读视图，不拷贝数据，查表返回指向映射内存的指针
+ *
+ * @note attach只检查头和目录的边界，内容的CRC由映射方（ConfigMap）在映射时校验
+ */
+class ConfigBlob {
+    public:
+        static constexpr size_t ALIGN = 8; // 表数据的对齐
+
+        /**
+         * @brief 关联一段已映射的配置区
+         *
+         * @param base 配置区起始地址，至少4字节对齐
+         * @param size 映射的长度
+         *
+         * @return 头和目录有效返回true
+         */
+        bool attach(const void* base, size_t size) {
+            m_base = nullptr;
+            m_head = nullptr;
+            if (!base || size < sizeof(ConfigHead)) return false;
+
+            const ConfigHead* head = static_cast<const ConfigHead*>(base);
+            if (head->magic != CONFIG_MAGIC || head->format != CONFIG_FORMAT) return false;
+            if (head->size > size || head->size < sizeof(ConfigHead) + head->count * sizeof(ConfigEntry)) return false;
+
+            m_base = static_cast<const uint8_t*>(base);
+            m_head = head;
+            return true;
+        }
+
+        bool valid() const { return m_head != nullptr; }
+        size_t size() const { return m_head ? m_head->size : 0; }
+        size_t count() const { return m_head ? m_head->count : 0; }
+        const uint8_t* data() const { return m_base; }
+
+        /**
+         * @brief 按ID和版本查表
+         *
+         * @param len 输出表数据长度，可为空
+         *
+         * @return 表数据，找不到、版本不符或越界时返回nullptr
+         */
+        const void* find(uint16_t id, uint16_t version, size_t* len = nullptr) const {
+            if (!m_head) return nullptr;
+            const ConfigEntry* entries = reinterpret_cast<const ConfigEntry*>(m_base + sizeof(ConfigHead));
+            for (size_t i = 0; i < m_head->count; i++) {
+                const ConfigEntry& e = entries[i];
+                if (e.id != id) continue;
+                if (e.version != version || e.offset % ALIGN || e.offset > m_head->size || e.len > m_head->size - e.offset) return nullptr;
+                if (len) *len = e.len;
+                return m_base + e.offset;
+            }
+            return nullptr;
+        }
+
+        // 按类型查表，数据长度必须等于sizeof(T)
+        template <class T>
+        const T* get(uint16_t id, uint16_t version) const {
+            size_t len = 0;
+            const void* p = find(id, version, &len);
+            return p && len == sizeof(T) ? static_cast<const T*>(p) : nullptr;
+        }
+
+    private:
+        const uint8_t* m_base = nullptr;
+        const ConfigHead* m_head = nullptr;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief 对数-线性直方图，用于统计延迟分布（us或周期）
+ *
+ * @note 小于8的值每个值一个桶；之后每个2的幂区间再均分为8个桶，相对误差不超过12.5%。
+ *       覆盖 [0, 2^20)，更大的值计入最后一个桶。记录只有几条整数指令，可以在控制循环中调用；
+ *       只允许一个任务记录，其他任务读取到的统计可能相差一次记录
+ */
+class LatencyHist {
+    public:
+        static constexpr int SUB_BITS = 3; // 每个2的幂区间的细分位数
+        static constexpr uint32_t SUB = 1 << SUB_BITS; // 每个区间的桶数
+        static constexpr int MAX_BITS = 20; // 覆盖的最大位数
+        static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB; // 桶数
+
+        // 值所在的桶
+        static size_t index(uint32_t value) {
+            if (value < SUB) return value;
+            int msb = 31 - __builtin_clz(value);
+            if (msb >= MAX_BITS) return BUCKETS - 1;
+            int shift = msb - SUB_BITS;
+            return (shift + 1) * SUB + ((value >> shift) & (SUB - 1));
+        }
+
+        // 桶的下界
+        static uint32_t lower(size_t idx) {
+            if (idx < SUB) return idx;
+            int shift = idx / SUB - 1;
+            return (SUB + idx % SUB) << shift;
+        }
+
+        // 桶的上界（不含）
+        static uint32_t upper(size_t idx) {
+            if (idx < SUB) return idx + 1;
+            return lower(idx) + (1u << (idx / SUB - 1));
+        }
+
+        void record(uint32_t value) {
+            m_bucket[index(value)]++;
+            m_count++;
+            if (value > m_max) m_max = value;
+            if (value < m_min) m_min = value;
+        }
+
+        // 合并另一个直方图的记录，用于汇总多个核心或多段时间的统计
+        void merge(const LatencyHist& other) {
+            for (size_t i = 0; i < BUCKETS; i++) m_bucket[i] += other.m_bucket[i];
+            m_count += other.m_count;
+            if (other.m_max > m_max) m_max = other.m_max;
+            if (other.m_min < m_min) m_min = other.m_min;
+        }
+
+        /**
+         * 分位数
+         * @param p 0~1
+         * @return 分位数所在桶的上界，保守估计；没有记录时返回0
+         */
+        uint32_t percentile(float p) const {
+            if (!m_count) return 0;
+            uint32_t target = (uint32_t)(p * m_count);
+            if (target >= m_count) target = m_count - 1;
+
+            uint32_t sum = 0;
+            for (size_t i = 0; i < BUCKETS; i++) {
+                sum += m_bucket[i];
+                if (sum > target) {
+                    uint32_t up = upper(i) - 1;
+                    return up < m_max ? up : m_max;
+                }
+            }
+            return m_max;
+        }
+
+        uint32_t count() const { return m_count; }
+        uint32_t max() const { return m_max; }
+        uint32_t min() const { return m_count ? m_min : 0; }
+        uint32_t bucket(size_t idx) const { return m_bucket[idx]; }
+
+        void reset() {
+            for (uint32_t& b : m_bucket) b = 0;
+            m_count = 0;
+            m_max = 0;
+            m_min = UINT32_MAX;
+        }
+
+    private:
+        uint32_t m_bucket[BUCKETS] = {};
+        uint32_t m_count = 0;
+        uint32_t m_max = 0;
+        uint32_t m_min = UINT32_MAX;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef INTERP_HPP
+#define INTERP_HPP
+
+#include <cstdint>
+#include "struct.hpp"
+
+/**
+ * @brief 把低速传感器流按时间戳对齐到高速流（如100Hz磁力计对齐到1kHz陀螺仪）
+ *
+ * @param maxAge 最新采样超过该时间（us）未更新时视为失效
+ *
+ * @note 保留最近两个带时间戳的采样：查询时刻落在两者之间时线性插值；
+ *       晚于最新采样时沿两点斜率外推，最多外推一个采样间隔，之后保持；早于较旧采样时取较旧值
+ */
+class Vec3Interp {
+    public:
+        explicit Vec3Interp(int64_t maxAge = 100000) : m_maxAge(maxAge) {}
+
+        // 压入一个采样，时间戳需单调递增，否则丢弃
+        void push(int64_t stamp, const Vec3lf& value) {
+            if (m_count && stamp <= m_t1) return;
+            m_t0 = m_t1;
+            m_v0 = m_v1;
+            m_t1 = stamp;
+            m_v1 = value;
+            if (m_count < 2) m_count++;
+        }
+
+        // 查询stamp时刻的值，没有采样或已失效时返回false
+        bool at(int64_t stamp, Vec3lf& out) const {
+            if (!m_count || stamp - m_t1 > m_maxAge) return false;
+            if (m_count < 2) {
+                out = m_v1;
+                return true;
+            }
+
+            int64_t span = m_t1 - m_t0;
+            int64_t t = stamp - m_t0;
+            if (t < 0) t = 0;
+            if (t > 2 * span) t = 2 * span; // 外推不超过一个采样间隔
+            double k = (double)t / span;
+
+            out.x = m_v0.x + (m_v1.x - m_v0.x) * k;
+            out.y = m_v0.y + (m_v1.y - m_v0.y) * k;
+            out.z = m_v0.z + (m_v1.z - m_v0.z) * k;
+            return true;
+        }
+
+        void reset() { m_count = 0; }
+
+    private:
+        int64_t m_maxAge;
+        int64_t m_t0 = 0, m_t1 = 0; // 较旧和最新采样的时间戳
+        Vec3lf m_v0, m_v1;
+        uint8_t m_count = 0; // 已有的采样数，最多2
+};
+
+#endif
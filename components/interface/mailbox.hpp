@@ -0,0 +1,62 @@
+#ifndef MAILBOX_HPP
+#define MAILBOX_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @brief 最新值邮箱（顺序锁），单写者多读者，写入和读取都不阻塞
+ *
+ * @param T 存放的值，需可平凡拷贝
+ *
+ * @note 写者写入前后各把序号加一，写入期间序号为奇数；读者拷贝前后序号一致且为偶数才算读到完整的值，
+ *       否则重试。写者不会等待读者。写者在写入中途被抢占时（例如被同一核心上更高优先级的读者抢占），
+ *       读者重试多少次都读不到完整的值，因此重试READ_RETRIES次后放弃，返回0
+ */
+template <class T>
+class Mailbox {
+    static_assert(std::is_trivially_copyable<T>::value, "Mailbox value must be trivially copyable");
+
+    public:
+        static constexpr uint32_t READ_RETRIES = 16; // 读取与写入重叠时的最大重试次数
+
+        // 写入新值，只允许一个写者
+        void write(const T& value) {
+            uint32_t seq = m_seq.load(std::memory_order_relaxed);
+            m_seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release); // 奇数序号先于数据可见
+            m_value = value;
+            m_seq.store(seq + 2, std::memory_order_release);
+        }
+
+        /**
+         * 读取最新值
+         * @param value 读到的值
+         * @return 值的版本号，每次写入加一；0表示从未写入，或重试READ_RETRIES次仍与写入重叠（此时value不变）
+         */
+        uint32_t read(T& value) const {
+            for (uint32_t i = 0; i < READ_RETRIES; i++) {
+                uint32_t begin = m_seq.load(std::memory_order_acquire);
+                if (!begin) return 0;
+                if (begin & 1) continue; // 写入中
+
+                T copy = m_value;
+                std::atomic_thread_fence(std::memory_order_acquire); // 数据先于第二次读序号
+                if (m_seq.load(std::memory_order_relaxed) != begin) continue; // 拷贝期间被改写
+
+                value = copy;
+                return begin >> 1;
+            }
+            return 0;
+        }
+
+        // 当前版本号，可用于判断是否有新值而不必拷贝
+        uint32_t version() const { return m_seq.load(std::memory_order_acquire) >> 1; }
+
+    private:
+        std::atomic<uint32_t> m_seq{0}; // 顺序号，奇数表示写入中
+        T m_value{};
+};
+
+#endif
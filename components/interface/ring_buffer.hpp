@@ -0,0 +1,84 @@
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/**
+ * @brief 字节环形缓冲区，读写均按连续段批量进行
+ *
+ * @param N 容量，必须是2的幂
+ *
+ * @note 读写下标单调递增，取模得到实际位置，满和空无需额外标志区分
+ */
+template <size_t N>
+class ByteRing {
+    static_assert(N && !(N & (N - 1)), "ByteRing size must be a power of 2");
+
+    public:
+        size_t size() const { return head - tail; } // 已缓存字节数
+        size_t space() const { return N - size(); } // 剩余空间
+        void clear() { head = tail = 0; }
+
+        // 获取可直接写入的连续空间，写完后用commit提交
+        size_t writeSpan(uint8_t*& ptr) {
+            size_t pos = head & (N - 1);
+            size_t len = N - pos;
+            if (len > space()) len = space();
+            ptr = buf + pos;
+            return len;
+        }
+        void commit(size_t len) { head += len; }
+
+        // 写入数据，空间不足时只写入能放下的部分，返回实际写入长度
+        size_t write(const void* data, size_t len) {
+            const uint8_t* src = static_cast<const uint8_t*>(data);
+            size_t done = 0;
+            while (done < len) {
+                uint8_t* ptr;
+                size_t n = writeSpan(ptr);
+                if (!n) break;
+                if (n > len - done) n = len - done;
+                memcpy(ptr, src + done, n);
+                commit(n);
+                done += n;
+            }
+            return done;
+        }
+
+        // 查看第off个字节，调用者保证off < size()
+        uint8_t peek(size_t off) const { return buf[(tail + off) & (N - 1)]; }
+
+        // 从第off个字节开始拷出len个字节，跨越环尾时分两段拷贝，调用者保证范围有效
+        void copyOut(size_t off, void* dst, size_t len) const {
+            size_t pos = (tail + off) & (N - 1);
+            size_t first = N - pos;
+            if (first > len) first = len;
+            memcpy(dst, buf + pos, first);
+            memcpy(static_cast<uint8_t*>(dst) + first, buf, len - first);
+        }
+
+        // 从第off个字节开始查找byte，返回其偏移，找不到返回size()
+        size_t find(uint8_t byte, size_t off = 0) const {
+            while (off < size()) {
+                size_t pos = (tail + off) & (N - 1);
+                size_t len = N - pos;
+                if (len > size() - off) len = size() - off;
+                const void* hit = memchr(buf + pos, byte, len);
+                if (hit) return off + (static_cast<const uint8_t*>(hit) - (buf + pos));
+                off += len;
+            }
+            return size();
+        }
+
+        // 丢弃最前面的len个字节
+        void drop(size_t len) { tail += len < size() ? len : size(); }
+
+    private:
+        uint8_t buf[N] = {};
+        size_t head = 0; // 写下标
+        size_t tail = 0; // 读下标
+};
+
+#endif
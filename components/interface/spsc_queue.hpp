@@ -0,0 +1,57 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 单生产者单消费者无锁队列，用于任务间传递不能丢失或需要按序处理的数据
+ *
+ * @param T 元素类型
+ * @param N 容量，必须是2的幂
+ *
+ * @note 读写下标单调递增，生产者只写head，消费者只写tail，不需要锁和关中断，
+ *       可以跨核心使用，也可以由中断写入、任务读出
+ */
+template <class T, size_t N>
+class SpscQueue {
+    static_assert(N && !(N & (N - 1)), "SpscQueue size must be a power of 2");
+
+    public:
+        // 生产者：压入一个元素，队列满时返回false
+        bool push(const T& value) {
+            uint32_t head = m_head.load(std::memory_order_relaxed);
+            if (head - m_tail.load(std::memory_order_acquire) >= N) return false;
+            m_buf[head & (N - 1)] = value;
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // 消费者：取出最早的元素，队列空时返回false
+        bool pop(T& value) {
+            uint32_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail == m_head.load(std::memory_order_acquire)) return false;
+            value = m_buf[tail & (N - 1)];
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // 消费者：查看最早的元素而不取出，队列空时返回nullptr
+        const T* front() const {
+            uint32_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail == m_head.load(std::memory_order_acquire)) return nullptr;
+            return &m_buf[tail & (N - 1)];
+        }
+
+        size_t size() const { return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire); }
+        bool empty() const { return size() == 0; }
+        static constexpr size_t capacity() { return N; }
+
+    private:
+        T m_buf[N] = {};
+        std::atomic<uint32_t> m_head{0}; // 写下标，只由生产者写入
+        std::atomic<uint32_t> m_tail{0}; // 读下标，只由消费者写入
+};
+
+#endif
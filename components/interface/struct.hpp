@@ -1,6 +1,8 @@
 #ifndef STRUCT_HPP
 #define STRUCT_HPP
 
+#include <cstdint>
+
 struct Vec3i
 {
     int x = 0;
@@ -30,4 +32,34 @@ struct Quaternionlf
     double z = 0.0;
 };
 
+// IMU校准数据，结构变动时递增版本号
+#define IMU_CALI_VERSION 1
+struct ImuCali
+{
+    Vec3lf gyroBias; // 陀螺仪零偏（°/s）
+    Vec3i accelBias; // 加速度计零偏（原始值）
+    Vec3lf accelGain; // 加速度计缩放
+};
+
+// 一次IMU采样，在采集阶段和融合阶段之间传递
+struct ImuSample
+{
+    int64_t stamp = 0; // 采样时刻（us），有数据就绪中断时为中断时刻，否则为读取时刻
+    Vec3lf gyro; // 陀螺仪（°/s，未去零偏）
+    Vec3lf accel; // 加速度计（原始值）
+    int64_t magStamp = 0; // 磁力计读取时刻（us），0表示本采样没有新的磁力计数据
+    Vec3lf mag; // 磁力计（原始值）
+};
+
+// 一次姿态估计结果，在融合阶段和通讯阶段之间传递
+struct AttiSample
+{
+    int64_t stamp = 0; // 对应IMU采样的时刻（us）
+    Vec3lf atti; // 姿态角（°）
+    Vec3lf gyroBias; // 当前陀螺仪零偏估计（°/s）
+    bool still = false; // 是否静止
+    bool magValid = false; // mag是否有效
+    Vec3lf mag; // 按时间戳对齐到stamp的磁力计（原始值）
+};
+
 #endif
@@ -2,27 +2,78 @@
 #define UART_DATA_PACK_HPP
 
 #include "cstdint"
+#include "cstddef"
 
+/**
+ * 帧格式：
+ * | 0x55 | 0xAA | ID | LEN | 负载(LEN字节) | CRC-16(小端) |
+ * CRC-16/MODBUS 覆盖帧头到负载结束。
+ *
+ * 负载为下面带ID的packed结构体。接收方按LEN拷贝，LEN小于结构体时其余字段保持默认值，
+ * 大于结构体时忽略多出的部分，因此在结构体末尾追加字段不会破坏旧的收发端。
+ */
 #define HEADER 0x55AA // 帧头
+#define HEADER_1 0x55 // 帧头第一字节
+#define HEADER_2 0xAA // 帧头第二字节
+
+// 帧头
+struct FrameHead
+{
+    uint8_t header1 = HEADER_1;
+    uint8_t header2 = HEADER_2;
+    uint8_t id = 0x00; // 消息ID
+    uint8_t len = 0x00; // 负载长度
+}__attribute__((packed)); // 不进行字节对齐
+
+// 消息ID，新增消息在此分配
+enum MSG_ID : uint8_t {
+    MSG_CMD         = 0x01, // 指令
+    MSG_FEEDBACK    = 0x02, // 反馈
+    MSG_ATTI_BATCH  = 0x03, // 批量姿态
+    MSG_TRACE       = 0x04, // 二进制日志
+    MSG_LATENCY     = 0x05, // 延迟统计
+    MSG_PROBE       = 0x06, // 耗时探针统计
+    MSG_LOG_REQ     = 0x07, // 上位机请求回放黑匣子
+    MSG_LOG_CHUNK   = 0x08, // 黑匣子记录
+
+    // 链路控制，0x10~0x1F，由COMM内部处理
+    MSG_BAUD_REQ     = 0x10, // 上位机请求切换波特率
+    MSG_BAUD_ACK     = 0x11, // 下位机应答
+    MSG_BAUD_CONFIRM = 0x12, // 上位机以新波特率确认
+    MSG_PING         = 0x13, // 时钟同步请求，双方均可发起
+    MSG_PONG         = 0x14, // 时钟同步应答
+    MSG_SEQ_RESET    = 0x15, // 上位机重启，清空可靠序号窗口
+};
+
+/**
+ * 可靠通道：
+ * RELIABLE消息带16位序号seq，0表示普通消息，1~65535循环使用。
+ * 下位机按序号去重，并在每个反馈中带回收到的最新序号ackSeq及其之前32个序号的接收位图ackBits，
+ * 上位机据此只重发未确认的消息，且重发次数有限。串口不会乱序，领先超过32的序号以其为新起点，
+ * 落后超过32的序号视为过期的重发而丢弃。上位机重启后先发送SeqReset，直到反馈中ackSeq为0才开始发送可靠消息。
+ */
 
 // 指令串口数据包
 struct RoBoCmd
 {
-    uint16_t header = 0x00;
+    static constexpr uint8_t ID = MSG_CMD;
+    static constexpr bool RELIABLE = true;
+
     float val1 = 0x00;
     float val2 = 0x00;
     float val3 = 0x00;
     float val4 = 0x00;
     uint8_t mode1 = 0x00;
     uint8_t mode2 = 0x00;
-    uint16_t checksum = 0x00;    // CRC-16
+    uint16_t seq = 0x00; // 可靠序号，0为普通指令，关键指令（如模式切换）由上位机编号并等待确认
 }__attribute__((packed)); // 不进行字节对齐
 
 
 // 反馈串口数据包
 struct RoBoFeedBack
 {
-    uint16_t header = HEADER;
+    static constexpr uint8_t ID = MSG_FEEDBACK;
+
     float roll = 0.0f;
     float pitch = 0.0f;
     float yaw = 0.0f;
@@ -31,9 +82,220 @@ struct RoBoFeedBack
     float vel_x = 0.0f;
     float vel_y = 0.0f;
     float vel_z = 0.0f;
-    uint8_t  status = 0x00;
+    uint8_t  status = 0x00; // 由Pipeline::setStatus提供，demo中为电池电压（0.1V）
     uint8_t  reserved2 = 0x00;
-    uint16_t checksum = 0x00;    // CRC-16
+    int64_t  stamp = 0; // 发送时刻（us），已同步时为上位机时钟，否则为本机时钟
+    uint8_t  synced = 0x00; // 1表示stamp已对齐到上位机时钟
+    uint16_t ackSeq = 0; // 收到的最新可靠序号，0为尚未收到
+    uint32_t ackBits = 0; // bit i 为1表示序号 ackSeq-1-i 已收到
+}__attribute__((packed)); // 不进行字节对齐
+
+// 批量姿态的采样编码
+enum ATTI_ENC : uint8_t {
+    ATTI_F32   = 0, // | dt(u16) | roll pitch yaw (float) |，14字节
+    ATTI_F16   = 1, // | dt(u16) | roll pitch yaw (半精度) |，8字节
+    ATTI_I16   = 2, // | dt(u16) | roll pitch yaw (int16，0.01°) |，8字节
+    ATTI_DELTA = 3, // 首个采样同ATTI_I16，之后 | dt(u16) | 与上一采样之差 (int8，0.01°，跨±180°回绕) |，5字节
+};
+
+/**
+ * 批量姿态，一帧携带多个带时间戳的采样
+ * dt为采样相对stamp的时间（us），data中按encoding依次排列count个采样
+ */
+struct AttiBatch
+{
+    static constexpr uint8_t ID = MSG_ATTI_BATCH;
+    static constexpr size_t MAX_DATA = 240; // 采样区最大长度
+
+    uint32_t stamp = 0; // 首个采样的时间戳（us）
+    uint8_t encoding = ATTI_DELTA; // 采样编码
+    uint8_t count = 0; // 采样数
+    uint8_t data[MAX_DATA] = {};
+
+    // 采样区实际使用的长度
+    size_t dataSize() const {
+        if (!count) return 0;
+        switch (encoding) {
+            case ATTI_F32: return count * 14;
+            case ATTI_F16:
+            case ATTI_I16: return count * 8;
+            default: return 8 + (count - 1) * 5;
+        }
+    }
+    // 实际发送的负载长度
+    size_t size() const { return sizeof(AttiBatch) - MAX_DATA + dataSize(); }
+}__attribute__((packed)); // 不进行字节对齐
+
+// 一条二进制日志，格式串由上位机按id查表，参数为原始32位值（浮点按位存放）
+struct TraceRecord
+{
+    uint32_t cycle = 0; // 写入时的CPU周期计数
+    uint16_t id = 0; // 日志ID，见trace_ids.hpp
+    uint8_t core = 0; // 写入的核心
+    uint8_t nargs = 0; // 参数个数
+    uint32_t args[4] = {}; // 参数
+}__attribute__((packed)); // 不进行字节对齐
+
+// 一批二进制日志
+struct TraceBatch
+{
+    static constexpr uint8_t ID = MSG_TRACE;
+    static constexpr size_t MAX_RECORDS = 10; // 每帧最多的日志条数
+
+    uint32_t cpuHz = 0; // CPU频率，上位机用于把周期换算为时间
+    uint16_t dropped = 0; // 自上一帧以来因缓冲区满丢弃的条数
+    uint8_t count = 0; // 本帧条数
+    TraceRecord records[MAX_RECORDS];
+
+    size_t size() const { return sizeof(TraceBatch) - (MAX_RECORDS - count) * sizeof(TraceRecord); }
+}__attribute__((packed)); // 不进行字节对齐
+
+// 单个阶段的延迟统计（us）
+struct LatencyStage
+{
+    uint32_t count = 0; // 统计次数
+    uint32_t p50 = 0;
+    uint32_t p90 = 0;
+    uint32_t p99 = 0;
+    uint32_t max = 0;
+}__attribute__((packed)); // 不进行字节对齐
+
+// 下位机各阶段的延迟分布，分位数取直方图桶的上界
+struct LatencyReport
+{
+    static constexpr uint8_t ID = MSG_LATENCY;
+
+    LatencyStage rx; // 帧到达到消息分发
+    LatencyStage proc; // 处理者onMsg的耗时
+    LatencyStage tx; // 帧进入发送缓冲区到交给串口驱动
+    uint32_t rtt = 0; // 时钟同步测得的最小往返时间
+    int64_t offset = 0; // 上位机时钟减本机时钟
+    float drift = 0.0f; // 上位机时钟相对本机的速率差（ppm）
+}__attribute__((packed)); // 不进行字节对齐
+
+// 单个耗时探针的统计（CPU周期），分位数取直方图桶的上界
+struct ProbeStat
+{
+    uint8_t id = 0; // 探针ID，见probe_ids.hpp
+    uint32_t count = 0; // 记录次数
+    uint32_t min = 0;
+    uint32_t p50 = 0;
+    uint32_t p99 = 0;
+    uint32_t max = 0;
+}__attribute__((packed)); // 不进行字节对齐
+
+// 各耗时探针的统计，自开机或上次清空起累计
+struct ProbeReport
+{
+    static constexpr uint8_t ID = MSG_PROBE;
+    static constexpr size_t MAX_PROBES = 10; // 每帧最多的探针数
+
+    uint32_t cpuHz = 0; // CPU频率，上位机用于把周期换算为时间
+    uint8_t count = 0; // 本帧探针数
+    ProbeStat probes[MAX_PROBES];
+
+    size_t size() const { return sizeof(ProbeReport) - (MAX_PROBES - count) * sizeof(ProbeStat); }
+}__attribute__((packed)); // 不进行字节对齐
+
+/**
+ * 黑匣子记录，flash中的存储格式与LogChunk中相同，32字节
+ * crc覆盖之前的30字节，擦除后的0xFF和掉电时写了一半的记录都校验不过
+ */
+struct FlightRecord
+{
+    uint32_t stamp = 0; // 采样时刻（us），约71分钟回绕
+    float atti[3] = {}; // roll pitch yaw（°）
+    int16_t gyro[3] = {}; // 角速度（1/16 °/s）
+    int16_t accel[3] = {}; // 加速度计原始值
+    uint16_t flags = 0; // 见LOG_FLAG
+    uint16_t crc = 0; // CRC-16/MODBUS
+}__attribute__((packed)); // 不进行字节对齐
+
+enum LOG_FLAG : uint16_t {
+    LOG_STILL     = 1 << 0, // 静止
+    LOG_MAG_VALID = 1 << 1, // 磁力计有效
+};
+
+// 上位机请求回放黑匣子，下位机从最旧的记录开始以LogChunk发出
+struct LogDumpReq
+{
+    static constexpr uint8_t ID = MSG_LOG_REQ;
+
+    uint8_t reserved = 0;
+}__attribute__((packed)); // 不进行字节对齐
+
+// 一批黑匣子记录，按时间顺序
+struct LogChunk
+{
+    static constexpr uint8_t ID = MSG_LOG_CHUNK;
+    static constexpr size_t MAX_RECORDS = 7; // 每帧最多的记录数
+
+    uint32_t index = 0; // 本帧首条记录在本次回放中的序号，上位机据此发现丢帧
+    uint8_t done = 0; // 1表示回放结束，本帧可以不带记录
+    uint8_t count = 0; // 本帧记录数
+    FlightRecord records[MAX_RECORDS];
+
+    size_t size() const { return sizeof(LogChunk) - (MAX_RECORDS - count) * sizeof(FlightRecord); }
+}__attribute__((packed)); // 不进行字节对齐
+
+/**
+ * 时钟同步（NTP方式）：
+ * 发起方以本机时钟t1发送 ClockPing，应答方记录收到时刻t2，以t3回复 ClockPong，发起方收到时刻为t4
+ * 往返 = (t4 - t1) - (t3 - t2)，偏移（应答方减发起方） = ((t2 - t1) + (t3 - t4)) / 2
+ */
+struct ClockPing
+{
+    static constexpr uint8_t ID = MSG_PING;
+
+    uint32_t seq = 0; // 序号，应答原样带回
+    int64_t t1 = 0; // 发起方发送时刻（us）
+}__attribute__((packed)); // 不进行字节对齐
+
+struct ClockPong
+{
+    static constexpr uint8_t ID = MSG_PONG;
+
+    uint32_t seq = 0;
+    int64_t t1 = 0; // 原样带回
+    int64_t t2 = 0; // 应答方收到时刻（us）
+    int64_t t3 = 0; // 应答方发送时刻（us）
+}__attribute__((packed)); // 不进行字节对齐
+
+// 上位机重启后发送，下位机清空可靠序号窗口，反馈中的ackSeq回到0
+struct SeqReset
+{
+    static constexpr uint8_t ID = MSG_SEQ_RESET;
+
+    uint8_t reserved = 0;
+}__attribute__((packed)); // 不进行字节对齐
+
+/**
+ * 波特率协商：
+ * 1. 上位机以当前波特率发送 BaudReq
+ * 2. 下位机回复 BaudAck，accept为1时发完应答后切换到新波特率
+ * 3. 上位机收到接受的应答后切换，并以新波特率发送 BaudConfirm
+ * 4. 下位机超时未收到 BaudConfirm 则退回原波特率，上位机同样超时退回
+ */
+struct BaudReq
+{
+    static constexpr uint8_t ID = MSG_BAUD_REQ;
+
+    uint32_t baud = 0; // 请求的波特率
+}__attribute__((packed)); // 不进行字节对齐
+
+struct BaudAck
+{
+    static constexpr uint8_t ID = MSG_BAUD_ACK;
+
+    uint32_t baud = 0; // 请求的波特率
+    uint8_t accept = 0; // 1接受，0拒绝
+}__attribute__((packed)); // 不进行字节对齐
+
+struct BaudConfirm
+{
+    static constexpr uint8_t ID = MSG_BAUD_CONFIRM;
+
+    uint32_t baud = 0; // 已切换的波特率
 }__attribute__((packed)); // 不进行字节对齐
 
 #endif
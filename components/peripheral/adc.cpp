@@ -1,29 +1,32 @@
 #include "adc.hpp"
 
-Adc::Adc(adc_unit_t adc_id, adc_channel_t ch) 
-    : success(false), m_adc_id(adc_id), m_ch(ch) {
+adc_oneshot_unit_handle_t Adc::s_units[SOC_ADC_PERIPH_NUM] = {};
+int Adc::s_refs[SOC_ADC_PERIPH_NUM] = {};
+
+Adc::Adc(adc_unit_t adc_id, adc_channel_t ch, adc_atten_t atten) 
+    : success(false), m_adc_id(adc_id), m_ch(ch), adc_handle(nullptr) {
         esp_err_t err;
-    // 配置ADC模数转换器
-    adc_oneshot_unit_init_cfg_t init_config = {
-        .unit_id = m_adc_id,
-    };
-    err = adc_oneshot_new_unit(&init_config, &adc_handle);
-    if (err != ESP_OK)
+    // 配置ADC模数转换器，同一单元只创建一次
+    adc_handle = _acquireUnit(m_adc_id);
+    if (!adc_handle)
         return;
     // 配置 ADC 通道
     adc_oneshot_chan_cfg_t config = {
-        .atten = ADC_ATTEN_DB_12,
+        .atten = atten,
         .bitwidth = ADC_BITWIDTH_DEFAULT
     };
     err = adc_oneshot_config_channel(adc_handle, m_ch, &config);
-    if (err != ESP_OK)
+    if (err != ESP_OK) {
+        _releaseUnit(m_adc_id);
         return;
+    }
+    m_cali.init(m_adc_id, m_ch, atten); // 未烧录校准参数时按标称量程换算
     success = true;
 }
 
 Adc::~Adc() {
     if (success)
-        adc_oneshot_del_unit(adc_handle);
+        _releaseUnit(m_adc_id);
 }
 
 int Adc::read() {
@@ -34,3 +37,39 @@ int Adc::read() {
         val = -1;
     return val;
 }
+
+int Adc::readMv() {
+    int val = read();
+    return val < 0 ? -1 : m_cali.toMv(val);
+}
+
+/**
+ * @brief 取得单元的共享句柄，第一次使用时创建
+ *
+ * @return 失败返回nullptr（单元号无效，或该单元已被AdcStream等占用）
+ */
+adc_oneshot_unit_handle_t Adc::_acquireUnit(adc_unit_t unit) {
+    if ((int)unit < 0 || (int)unit >= SOC_ADC_PERIPH_NUM)
+        return nullptr;
+    if (!s_units[unit]) {
+        adc_oneshot_unit_init_cfg_t init_config = {
+            .unit_id = unit,
+        };
+        if (adc_oneshot_new_unit(&init_config, &s_units[unit]) != ESP_OK) {
+            s_units[unit] = nullptr;
+            return nullptr;
+        }
+    }
+    s_refs[unit]++;
+    return s_units[unit];
+}
+
+/**
+ * @brief 释放单元的引用，最后一个通道释放时删除单元
+ */
+void Adc::_releaseUnit(adc_unit_t unit) {
+    if (--s_refs[unit] > 0)
+        return;
+    adc_oneshot_del_unit(s_units[unit]);
+    s_units[unit] = nullptr;
+}
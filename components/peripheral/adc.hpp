@@ -2,19 +2,39 @@
 #define ADC_HPP
 
 #include "esp_adc/adc_oneshot.h"
+#include "soc/soc_caps.h"
+#include "adc_calibration.hpp"
 
+/**
+ * @brief 单次读取ADC，同一ADC单元的多个通道共享一个oneshot单元
+ *
+ * @param adc_id ADC单元
+ * @param ch 通道
+ * @param atten 衰减，决定量程，12dB约0~3.1V
+ *
+ * @note 每次读取都阻塞一次转换；需要高频、滤波或多通道采样时用AdcMeter
+ */
 class Adc {
     public:
-        Adc(adc_unit_t adc_id, adc_channel_t ch);
+        Adc(adc_unit_t adc_id, adc_channel_t ch, adc_atten_t atten = ADC_ATTEN_DB_12);
         ~Adc();
 
         int read();
+        int readMv(); // 读取一次并按校准换算为毫伏，失败返回-1
+        bool isCalibrated() const { return m_cali.scheme() != AdcCalibration::NOMINAL; }
 
     private:
         bool success;
         adc_unit_t m_adc_id;
         adc_channel_t m_ch;
+        AdcCalibration m_cali;
         adc_oneshot_unit_handle_t adc_handle; // 用于配置adc的结构体
+
+        static adc_oneshot_unit_handle_t s_units[SOC_ADC_PERIPH_NUM]; // 各单元共享的句柄
+        static int s_refs[SOC_ADC_PERIPH_NUM]; // 各单元的引用计数
+
+        static adc_oneshot_unit_handle_t _acquireUnit(adc_unit_t unit);
+        static void _releaseUnit(adc_unit_t unit);
 };
 
 #endif
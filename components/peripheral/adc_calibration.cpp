@@ -0,0 +1,80 @@
+#include "adc_calibration.hpp"
+#include <cstddef>
+#include "soc/soc_caps.h"
+
+namespace {
+    // 各衰减下的标称满量程（mV），依次为0dB 2.5dB 6dB 12dB
+    constexpr int NOMINAL_FULL_MV[] = {950, 1250, 1750, 3100};
+}
+
+AdcCalibration::AdcCalibration() :
+    m_handle(nullptr),
+    m_scheme(NOMINAL),
+    m_full_mv(NOMINAL_FULL_MV[3]),
+    m_max_raw(4095) {
+}
+
+AdcCalibration::~AdcCalibration() {
+    _release();
+}
+
+/**
+ * @brief 创建校准方案
+ *
+ * @param unit ADC单元
+ * @param ch 通道，曲线拟合按通道校准
+ * @param atten 衰减，须与采样时相同
+ * @param bitwidth 原始值位宽
+ *
+ * @return 用上eFuse校准时返回true，否则退回标称换算并返回false，toMv仍可用
+ */
+bool AdcCalibration::init(adc_unit_t unit, adc_channel_t ch, adc_atten_t atten, adc_bitwidth_t bitwidth) {
+    _release();
+    int bits = bitwidth == ADC_BITWIDTH_DEFAULT ? SOC_ADC_RTC_MAX_BITWIDTH : (int)bitwidth;
+    m_max_raw = (1 << bits) - 1;
+    m_full_mv = (size_t)atten < sizeof(NOMINAL_FULL_MV) / sizeof(NOMINAL_FULL_MV[0]) ? NOMINAL_FULL_MV[atten] : NOMINAL_FULL_MV[3];
+    (void) ch;
+
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t curve = {};
+    curve.unit_id = unit;
+    curve.chan = ch;
+    curve.atten = atten;
+    curve.bitwidth = bitwidth;
+    if (adc_cali_create_scheme_curve_fitting(&curve, &m_handle) == ESP_OK) {
+        m_scheme = CURVE_FITTING;
+        return true;
+    }
+#endif
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t line = {};
+    line.unit_id = unit;
+    line.atten = atten;
+    line.bitwidth = bitwidth;
+    if (adc_cali_create_scheme_line_fitting(&line, &m_handle) == ESP_OK) {
+        m_scheme = LINE_FITTING;
+        return true;
+    }
+#endif
+    (void) unit;
+    m_handle = nullptr;
+    return false;
+}
+
+int AdcCalibration::toMv(int raw) const {
+    int mv;
+    if (m_handle && adc_cali_raw_to_voltage(m_handle, raw, &mv) == ESP_OK) return mv;
+    return raw * m_full_mv / m_max_raw;
+}
+
+void AdcCalibration::_release() {
+    if (!m_handle) return;
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    if (m_scheme == CURVE_FITTING) adc_cali_delete_scheme_curve_fitting(m_handle);
+#endif
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    if (m_scheme == LINE_FITTING) adc_cali_delete_scheme_line_fitting(m_handle);
+#endif
+    m_handle = nullptr;
+    m_scheme = NOMINAL;
+}
@@ -0,0 +1,40 @@
+#ifndef ADC_CALIBRATION_HPP
+#define ADC_CALIBRATION_HPP
+
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+
+/**
+ * @brief ADC原始值到毫伏的换算，优先用eFuse中的曲线拟合校准，其次线性拟合
+ *
+ * @note 芯片未烧录校准参数时按各衰减的标称满量程线性换算，误差可达几十毫伏。
+ *       同一通道的单次读取和连续采样可共用一个对象
+ */
+class AdcCalibration {
+    public:
+        enum SCHEME {
+            NOMINAL = 0, // 标称满量程，未校准
+            CURVE_FITTING,
+            LINE_FITTING
+        };
+
+        AdcCalibration();
+        ~AdcCalibration();
+
+        AdcCalibration(const AdcCalibration&) = delete;
+        AdcCalibration& operator=(const AdcCalibration&) = delete;
+
+        bool init(adc_unit_t unit, adc_channel_t ch, adc_atten_t atten, adc_bitwidth_t bitwidth = ADC_BITWIDTH_DEFAULT); // 创建校准方案
+        int toMv(int raw) const; // 原始值换算为毫伏
+        SCHEME scheme() const { return m_scheme; }
+
+    private:
+        adc_cali_handle_t m_handle;
+        SCHEME m_scheme;
+        int m_full_mv; // 标称换算的满量程（mV）
+        int m_max_raw; // 标称换算的原始值最大值
+
+        void _release();
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "adc_meter.hpp"
+
+AdcMeter::AdcMeter(adc_unit_t unit, const adc_channel_t* channels, size_t num, const AdcMeterConfig& cfg) :
+    m_stream(unit, channels, num, cfg.stream),
+    m_unit(unit),
+    m_channels(),
+    m_num(num < ADC_STREAM_MAX_CHANNELS ? num : ADC_STREAM_MAX_CHANNELS),
+    m_cfg(cfg) {
+    for (size_t i = 0; i < m_num; i++) m_channels[i] = channels[i];
+    for (std::atomic<int>& mv : m_mv) mv.store(-1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 设置滤波器，创建各通道校准方案和连续采样驱动
+ *
+ * @return 抽取比超出CIC的32位范围或驱动创建失败时返回false；
+ *         没有eFuse校准不算失败，按标称量程换算
+ */
+bool AdcMeter::init() {
+    const uint32_t maxRaw = (1u << SOC_ADC_DIGI_MAX_BITWIDTH) - 1;
+    for (size_t i = 0; i < m_num; i++) {
+        if (!m_filter[i].setRatio(m_cfg.decimate, maxRaw)) return false;
+        m_cali[i].init(m_unit, m_channels[i], m_cfg.stream.atten, (adc_bitwidth_t)SOC_ADC_DIGI_MAX_BITWIDTH);
+    }
+    return m_stream.init();
+}
+
+bool AdcMeter::start(UBaseType_t priority, BaseType_t core) {
+    return m_stream.start(_onBatch, this, priority, core);
+}
+
+bool AdcMeter::getMv(size_t index, int& mv) const {
+    if (index >= m_num) return false;
+    mv = m_mv[index].load(std::memory_order_relaxed);
+    return mv >= 0;
+}
+
+uint32_t AdcMeter::getOutputHz() const {
+    return m_cfg.decimate ? m_stream.getChannelHz() / m_cfg.decimate : 0;
+}
+
+bool AdcMeter::isCalibrated() const {
+    for (size_t i = 0; i < m_num; i++) {
+        if (m_cali[i].scheme() == AdcCalibration::NOMINAL) return false;
+    }
+    return m_num > 0;
+}
+
+/**
+ * @brief 每帧每通道跑一遍CIC，只对抽取后的输出做校准换算，保留最后一个
+ */
+void AdcMeter::_onBatch(const AdcBatch& batch, void* arg) {
+    AdcMeter& self = *static_cast<AdcMeter*>(arg);
+    for (size_t c = 0; c < batch.channels; c++) {
+        uint32_t last = 0;
+        if (self.m_filter[c].process(batch.data[c], batch.count[c], [&last](uint32_t out) { last = out; }))
+            self.m_mv[c].store(self.m_cali[c].toMv(last), std::memory_order_relaxed);
+    }
+}
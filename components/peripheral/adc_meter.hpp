@@ -0,0 +1,54 @@
+#ifndef ADC_METER_HPP
+#define ADC_METER_HPP
+
+#include <atomic>
+#include "adc_stream.hpp"
+#include "adc_calibration.hpp"
+#include "cic_decimator.hpp"
+
+// 电压测量参数
+struct AdcMeterConfig
+{
+    AdcStreamConfig stream; // 连续采样参数，衰减决定各通道量程
+    uint32_t decimate = 64; // CIC抽取比，每通道输出频率为 stream.sampleHz / 通道数 / decimate
+};
+
+/**
+ * @brief 多通道电压测量：连续采样 -> 每通道二阶CIC抽取 -> 校准换算为毫伏
+ *
+ * @param unit ADC单元
+ * @param channels 测量的通道，最多ADC_STREAM_MAX_CHANNELS个
+ * @param num 通道数
+ * @param cfg 测量参数
+ *
+ * @note 滤波在采样任务中按批处理，每个输出才换算一次毫伏；
+ *       结果存为原子量，任意任务可无锁读取最新值
+ */
+class AdcMeter {
+    public:
+        AdcMeter(adc_unit_t unit, const adc_channel_t* channels, size_t num, const AdcMeterConfig& cfg = AdcMeterConfig());
+
+        bool init(); // 创建各通道校准方案和连续采样驱动
+        bool start(UBaseType_t priority, BaseType_t core = tskNO_AFFINITY); // 开始测量
+        bool getMv(size_t index, int& mv) const; // 第index个通道的最新电压，尚无输出时返回false
+        uint32_t getOutputHz() const; // 每通道输出频率
+        bool isCalibrated() const; // 所有通道都用上了eFuse校准
+        AdcStreamStats getStats() const { return m_stream.getStats(); }
+
+    private:
+        using Filter = CicDecimator<2>;
+
+        AdcStream m_stream;
+        adc_unit_t m_unit;
+        adc_channel_t m_channels[ADC_STREAM_MAX_CHANNELS];
+        size_t m_num;
+        AdcMeterConfig m_cfg;
+
+        Filter m_filter[ADC_STREAM_MAX_CHANNELS]; // 只由采样任务访问
+        AdcCalibration m_cali[ADC_STREAM_MAX_CHANNELS];
+        std::atomic<int> m_mv[ADC_STREAM_MAX_CHANNELS]; // 最新电压，-1为尚无输出
+
+        static void _onBatch(const AdcBatch& batch, void* arg); // 在采样任务中滤波并换算
+};
+
+#endif
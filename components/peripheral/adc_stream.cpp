@@ -0,0 +1,204 @@
+#include "adc_stream.hpp"
+#include "sdkconfig.h"
+#include "sysmon.hpp"
+#include "esp_attr.h"
+
+// 转换结果格式：ESP32和ESP32-S2为TYPE1，其余芯片为TYPE2
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define ADC_STREAM_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define ADC_STREAM_CHANNEL(p) ((p)->type1.channel)
+#define ADC_STREAM_DATA(p) ((p)->type1.data)
+#else
+#define ADC_STREAM_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define ADC_STREAM_CHANNEL(p) ((p)->type2.channel)
+#define ADC_STREAM_DATA(p) ((p)->type2.data)
+#endif
+
+AdcStream::AdcStream(adc_unit_t unit, const adc_channel_t* channels, size_t num, const AdcStreamConfig& cfg) :
+    m_unit(unit),
+    m_channels(),
+    m_num(num < ADC_STREAM_MAX_CHANNELS ? num : ADC_STREAM_MAX_CHANNELS),
+    m_cfg(cfg),
+    m_handle(nullptr),
+    m_running(false),
+    m_cb(nullptr),
+    m_arg(nullptr),
+    m_task(nullptr),
+    m_frames(0),
+    m_samples(0),
+    m_overflows(0),
+    m_invalid(0) {
+    for (int8_t& idx : m_index) idx = -1;
+    for (size_t i = 0; i < m_num; i++) {
+        m_channels[i] = channels[i];
+        if ((size_t)channels[i] < CHANNEL_MAP) m_index[channels[i]] = i;
+    }
+}
+
+AdcStream::~AdcStream() {
+    if (!m_handle) return;
+    stop();
+    adc_continuous_deinit(m_handle);
+}
+
+/**
+ * @brief 创建连续采样驱动，配置扫描表和中断回调
+ *
+ * @return 成功返回true，采样频率超出芯片范围时返回false
+ */
+bool AdcStream::init() {
+    if (m_handle) return true;
+    if (!m_num || m_cfg.sampleHz < SOC_ADC_SAMPLE_FREQ_THRES_LOW || m_cfg.sampleHz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) return false;
+
+    esp_err_t err;
+    adc_continuous_handle_cfg_t handleConfig = {};
+    handleConfig.max_store_buf_size = FRAME_BYTES * (m_cfg.poolFrames ? m_cfg.poolFrames : 1);
+    handleConfig.conv_frame_size = FRAME_BYTES;
+    err = adc_continuous_new_handle(&handleConfig, &m_handle);
+    if (err != ESP_OK) {
+        m_handle = nullptr;
+        return false;
+    }
+
+    // 扫描表，按顺序循环转换各通道
+    adc_digi_pattern_config_t pattern[ADC_STREAM_MAX_CHANNELS] = {};
+    for (size_t i = 0; i < m_num; i++) {
+        pattern[i].atten = m_cfg.atten;
+        pattern[i].channel = m_channels[i];
+        pattern[i].unit = m_unit;
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    adc_continuous_config_t config = {};
+    config.pattern_num = m_num;
+    config.adc_pattern = pattern;
+    config.sample_freq_hz = m_cfg.sampleHz;
+    config.conv_mode = m_unit == ADC_UNIT_1 ? ADC_CONV_SINGLE_UNIT_1 : ADC_CONV_SINGLE_UNIT_2;
+    config.format = ADC_STREAM_FORMAT;
+    err = adc_continuous_config(m_handle, &config);
+
+    adc_continuous_evt_cbs_t cbs = {};
+    cbs.on_conv_done = _onConvDone;
+    cbs.on_pool_ovf = _onOverflow;
+    if (err == ESP_OK) err = adc_continuous_register_event_callbacks(m_handle, &cbs, this);
+
+    if (err != ESP_OK) {
+        adc_continuous_deinit(m_handle);
+        m_handle = nullptr;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 启动采样任务（首次调用时创建）并开始转换
+ *
+ * @param cb 每帧调用一次的回调，在采样任务中执行
+ * @param arg 回调参数
+ * @param priority 采样任务优先级
+ * @param core 绑定的核心
+ */
+bool AdcStream::start(Callback cb, void* arg, UBaseType_t priority, BaseType_t core) {
+    if (!m_handle || m_running) return false;
+    m_cb = cb;
+    m_arg = arg;
+
+    if (!m_task.load(std::memory_order_acquire)) {
+        TaskHandle_t task = nullptr;
+        if (!SYSMON::createTask(_task, "adcStream", TASK_STACK, this, priority, &task, core)) return false;
+        m_task.store(task, std::memory_order_release);
+    }
+
+    if (adc_continuous_start(m_handle) != ESP_OK) return false;
+    m_running = true;
+    return true;
+}
+
+/**
+ * @brief 停止转换，驱动中未读出的数据丢弃
+ */
+bool AdcStream::stop() {
+    if (!m_running) return false;
+    m_running = false;
+    return adc_continuous_stop(m_handle) == ESP_OK;
+}
+
+uint32_t AdcStream::getChannelHz() const {
+    return m_num ? m_cfg.sampleHz / m_num : 0;
+}
+
+AdcStreamStats AdcStream::getStats() const {
+    AdcStreamStats stats;
+    stats.frames = m_frames.load(std::memory_order_relaxed);
+    stats.samples = m_samples.load(std::memory_order_relaxed);
+    stats.overflows = m_overflows.load(std::memory_order_relaxed);
+    stats.invalid = m_invalid.load(std::memory_order_relaxed);
+    return stats;
+}
+
+/**
+ * @brief 把一帧转换结果按通道拆分，调用回调
+ *
+ * @param len 帧的字节数
+ */
+void AdcStream::_process(size_t len) {
+    AdcBatch batch;
+    batch.channels = m_num;
+    uint32_t invalid = 0;
+
+    for (size_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t* p = reinterpret_cast<const adc_digi_output_data_t*>(&m_frame[i]);
+        uint32_t ch = ADC_STREAM_CHANNEL(p);
+        int idx = ch < CHANNEL_MAP ? m_index[ch] : -1;
+        if (idx < 0) {
+            invalid++;
+            continue;
+        }
+        m_demux[idx][batch.count[idx]++] = ADC_STREAM_DATA(p);
+    }
+    for (size_t i = 0; i < m_num; i++) batch.data[i] = m_demux[i];
+
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+    m_samples.fetch_add(len / SOC_ADC_DIGI_RESULT_BYTES, std::memory_order_relaxed);
+    if (invalid) m_invalid.fetch_add(invalid, std::memory_order_relaxed);
+    if (m_cb) m_cb(batch, m_arg);
+}
+
+/**
+ * @brief 一帧转换完成中断，只唤醒采样任务
+ */
+bool IRAM_ATTR AdcStream::_onConvDone(adc_continuous_handle_t handle, const adc_continuous_evt_data_t* edata, void* arg) {
+    (void) handle;
+    (void) edata;
+    AdcStream& self = *static_cast<AdcStream*>(arg);
+    TaskHandle_t task = self.m_task.load(std::memory_order_acquire);
+    if (!task) return false;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task, &woken);
+    return woken == pdTRUE; // 返回true时驱动在中断退出时切换任务
+}
+
+/**
+ * @brief 驱动缓冲满中断，采样任务来不及读取，只计数
+ */
+bool IRAM_ATTR AdcStream::_onOverflow(adc_continuous_handle_t handle, const adc_continuous_evt_data_t* edata, void* arg) {
+    (void) handle;
+    (void) edata;
+    static_cast<AdcStream*>(arg)->m_overflows.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+/**
+ * @brief 采样任务：被转换完成中断唤醒后读出驱动中所有完整的帧
+ */
+void AdcStream::_task(void* arg) {
+    AdcStream& self = *static_cast<AdcStream*>(arg);
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint32_t len = 0;
+        while (adc_continuous_read(self.m_handle, self.m_frame, FRAME_BYTES, &len, 0) == ESP_OK) {
+            self._process(len);
+        }
+    }
+}
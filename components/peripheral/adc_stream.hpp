@@ -0,0 +1,100 @@
+#ifndef ADC_STREAM_HPP
+#define ADC_STREAM_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_adc/adc_continuous.h"
+#include "soc/soc_caps.h"
+
+// 连续采样参数
+struct AdcStreamConfig
+{
+    uint32_t sampleHz = 20000; // 所有通道合计的转换频率，每个通道为sampleHz / 通道数
+    adc_atten_t atten = ADC_ATTEN_DB_12; // 各通道的衰减
+    uint32_t poolFrames = 4; // 驱动内部缓冲的帧数，任务来不及读取时吸收
+};
+
+#define ADC_STREAM_MAX_CHANNELS 8 // 最多扫描的通道数
+
+// 一批按通道拆分的采样，只在回调期间有效
+struct AdcBatch
+{
+    size_t channels = 0; // 通道数，与构造时的顺序相同
+    const uint16_t* data[ADC_STREAM_MAX_CHANNELS] = {}; // 各通道的原始值
+    uint16_t count[ADC_STREAM_MAX_CHANNELS] = {}; // 各通道的采样数
+};
+
+// 连续采样统计
+struct AdcStreamStats
+{
+    uint32_t frames = 0; // 处理的DMA帧数
+    uint32_t samples = 0; // 处理的转换数
+    uint32_t overflows = 0; // 驱动缓冲满丢弃数据的次数
+    uint32_t invalid = 0; // 通道号不在扫描表中的转换数
+};
+
+/**
+ * @brief 连续模式多通道ADC，按固定频率循环扫描各通道，转换结果经DMA写入缓冲区，
+ *        每帧在任务中按通道拆分后批量交给回调
+ *
+ * @param unit ADC单元
+ * @param channels 扫描的通道，最多ADC_STREAM_MAX_CHANNELS个
+ * @param num 通道数
+ * @param cfg 采样参数
+ *
+ * @note 中断中只唤醒任务，CPU开销与每帧一次的拆分成正比，与采样率基本无关。
+ *       同一ADC单元不能同时用于Adc单次读取；数据为原始值，滤波和毫伏换算见AdcMeter
+ */
+class AdcStream {
+    public:
+        static constexpr size_t FRAME_CONV = 256; // 每帧的转换数
+        static constexpr size_t FRAME_BYTES = FRAME_CONV * SOC_ADC_DIGI_RESULT_BYTES; // 每帧的字节数
+        static constexpr uint32_t TASK_STACK = 3072; // 采样任务栈大小
+
+        using Callback = void (*)(const AdcBatch& batch, void* arg); // 在采样任务中调用，不应阻塞
+
+        AdcStream(adc_unit_t unit, const adc_channel_t* channels, size_t num, const AdcStreamConfig& cfg = AdcStreamConfig());
+        ~AdcStream();
+
+        AdcStream(const AdcStream&) = delete;
+        AdcStream& operator=(const AdcStream&) = delete;
+
+        bool init(); // 创建连续采样驱动并配置扫描表
+        bool start(Callback cb, void* arg, UBaseType_t priority, BaseType_t core = tskNO_AFFINITY); // 启动采样任务和转换
+        bool stop(); // 停止转换，采样任务保持等待
+        uint32_t getChannelHz() const; // 每个通道的采样频率
+        AdcStreamStats getStats() const;
+
+    private:
+        static constexpr size_t CHANNEL_MAP = 16; // 通道号到扫描序号的映射表长度
+
+        adc_unit_t m_unit;
+        adc_channel_t m_channels[ADC_STREAM_MAX_CHANNELS];
+        size_t m_num;
+        AdcStreamConfig m_cfg;
+        int8_t m_index[CHANNEL_MAP]; // 通道号 -> 扫描序号，-1为不在扫描表中
+
+        adc_continuous_handle_t m_handle;
+        bool m_running;
+        Callback m_cb;
+        void* m_arg;
+        std::atomic<TaskHandle_t> m_task; // 采样任务，转换完成中断据此唤醒
+
+        uint8_t m_frame[FRAME_BYTES]; // 从驱动读出的一帧
+        uint16_t m_demux[ADC_STREAM_MAX_CHANNELS][FRAME_CONV]; // 按通道拆分后的采样
+
+        std::atomic<uint32_t> m_frames;
+        std::atomic<uint32_t> m_samples;
+        std::atomic<uint32_t> m_overflows;
+        std::atomic<uint32_t> m_invalid;
+
+        void _process(size_t len); // 拆分一帧并调用回调
+        static bool _onConvDone(adc_continuous_handle_t handle, const adc_continuous_evt_data_t* edata, void* arg);
+        static bool _onOverflow(adc_continuous_handle_t handle, const adc_continuous_evt_data_t* edata, void* arg);
+        static void _task(void* arg); // 采样任务
+};
+
+#endif
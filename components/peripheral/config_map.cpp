@@ -0,0 +1,96 @@
+#include "config_map.hpp"
+#include "esp_log.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include "esp_rom_crc.h"
+#endif
+
+namespace {
+    constexpr const char* TAG = "Config"; // 日志标签
+
+    // 标准CRC-32（与zlib.crc32相同）
+    uint32_t crc32(const uint8_t* data, size_t len) {
+#if CONFIG_IDF_TARGET_LINUX
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t i = 0; i < len; i++) {
+            crc ^= data[i];
+            for (int k = 0; k < 8; k++) crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+        return ~crc;
+#else
+        return esp_rom_crc32_le(0, data, len);
+#endif
+    }
+}
+
+ConfigMap::ConfigMap() :
+    m_ptr(nullptr),
+    m_size(0) {
+}
+
+ConfigMap::~ConfigMap() {
+    unmap();
+}
+
+/**
+ * @brief 映射配置区并校验头、目录和CRC
+ *
+ * @param label 芯片上为分区名，linux目标上为文件路径
+ *
+ * @return 配置区有效返回true，否则不保持映射
+ */
+bool ConfigMap::map(const char* label) {
+    unmap();
+
+#if CONFIG_IDF_TARGET_LINUX
+    int fd = open(label, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // 映射保持有效
+    if (ptr == MAP_FAILED) return false;
+    m_ptr = ptr;
+    m_size = st.st_size;
+#else
+    const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!part) {
+        ESP_LOGE(TAG, "Partition %s not found !", label);
+        return false;
+    }
+    if (esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &m_ptr, &m_handle) != ESP_OK) return false;
+    m_size = part->size;
+#endif
+
+    const uint8_t* base = static_cast<const uint8_t*>(m_ptr);
+    bool ok = m_blob.attach(m_ptr, m_size);
+    if (ok) {
+        const ConfigHead* head = static_cast<const ConfigHead*>(m_ptr);
+        ok = crc32(base + sizeof(ConfigHead), head->size - sizeof(ConfigHead)) == head->crc;
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "Config %s invalid !", label);
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+void ConfigMap::unmap() {
+    m_blob.attach(nullptr, 0);
+    if (!m_ptr) return;
+#if CONFIG_IDF_TARGET_LINUX
+    munmap(const_cast<void*>(m_ptr), m_size);
+#else
+    esp_partition_munmap(m_handle);
+#endif
+    m_ptr = nullptr;
+    m_size = 0;
+}
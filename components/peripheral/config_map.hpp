@@ -0,0 +1,39 @@
+#ifndef CONFIG_MAP_HPP
+#define CONFIG_MAP_HPP
+
+#include <cstddef>
+#include "sdkconfig.h"
+#include "config_blob.hpp"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_partition.h"
+#endif
+
+/**
+ * @brief 把只读配置区映射到地址空间，经ConfigBlob零拷贝查表
+ *
+ * @note 芯片上以esp_partition_mmap映射config分区，数据经cache直接读取flash，不占用RAM；
+ *       linux目标上以mmap映射同样布局的文件，label为文件路径。
+ *       映射时校验一次CRC，之后查表只遍历目录
+ */
+class ConfigMap {
+    public:
+        ConfigMap();
+        ~ConfigMap();
+
+        ConfigMap(const ConfigMap&) = delete;
+        ConfigMap& operator=(const ConfigMap&) = delete;
+
+        bool map(const char* label); // 映射并校验配置区
+        void unmap(); // 解除映射，之前查到的指针全部失效
+        const ConfigBlob& blob() const { return m_blob; }
+
+    private:
+        ConfigBlob m_blob;
+        const void* m_ptr; // 映射的起始地址
+        size_t m_size; // 映射的长度
+#if !CONFIG_IDF_TARGET_LINUX
+        esp_partition_mmap_handle_t m_handle;
+#endif
+};
+
+#endif
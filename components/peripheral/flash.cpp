@@ -1,16 +1,23 @@
 #include "flash.hpp"
+#include "esp_rom_crc.h"
+#include <cstring>
 
 Flash::Flash() 
-    :success(false) {
+    :success(false),
+    m_nvs(0),
+    m_batch(0) {
 }
 
 Flash::~Flash() {
+    if (success) nvs_close(m_nvs); // 关闭句柄
 }
 
 /**
- * @brief 初始化NVS分区
+ * @brief 初始化NVS分区，打开存储命名空间的句柄供之后的读写共用
  */
 bool Flash::init() {
+    if (success) return true;
+
     esp_err_t err;
     
     err = nvs_flash_init(); // 初始化分区
@@ -25,6 +32,10 @@ bool Flash::init() {
     else if (err == ESP_OK); // 首次初始化就成功
     else return false; // 首次初始化失败的非一般情况
 
+    // 打开nvs句柄
+    err = nvs_open(STORAGE_NAMESPACE, NVS_READWRITE, &m_nvs);
+    if (err != ESP_OK) return false;
+
     success = true;
     return true;
 }
@@ -35,25 +46,21 @@ bool Flash::init() {
  * @param key 键
  * @param value 值
  * @param len 值长度
+ * 
+ * @note 批量写入期间不提交，由commitBatch统一提交
  */
 bool Flash::saveAsBlob(const char* key, const void* value, size_t len) {
     if (!success) return false;
 
     esp_err_t err;
 
-    // 打开nvs句柄
-    err = nvs_open(STORAGE_NAMESPACE, NVS_READWRITE, &m_nvs);
-    if (err != ESP_OK) return false;
-
     err = nvs_set_blob(m_nvs, key, value, len); // 设置写入参数
     if (err != ESP_OK) return false;
 
-    err = nvs_commit(m_nvs); // 提交写入
-    if (err != ESP_OK) return false;
-
-    nvs_close(m_nvs); // 关闭句柄
+    if (m_batch) return true;
 
-    return true;
+    err = nvs_commit(m_nvs); // 提交写入
+    return err == ESP_OK;
 }
 
 /**
@@ -66,16 +73,102 @@ bool Flash::saveAsBlob(const char* key, const void* value, size_t len) {
 bool Flash::readAsBlob(const char* key, void* data_buf, size_t* len) {
     if (!success) return false;
 
-    esp_err_t err;
+    esp_err_t err = nvs_get_blob(m_nvs, key, data_buf, len); //读出
+    return err == ESP_OK;
+}
 
-    // 打开nvs句柄
-    err = nvs_open(STORAGE_NAMESPACE, NVS_READWRITE, &m_nvs);
-    if (err != ESP_OK) return false;
+/**
+ * @brief 存储一条带版本号和CRC32的记录
+ * 
+ * @param key 键
+ * @param version 数据结构版本，结构体变动时递增
+ * @param value 值
+ * @param len 值长度，不超过RECORD_MAX_SIZE
+ */
+bool Flash::saveRecord(const char* key, uint16_t version, const void* value, size_t len) {
+    if (len > RECORD_MAX_SIZE) return false;
 
-    err = nvs_get_blob(m_nvs, key, data_buf, len); //读出
-    if (err != ESP_OK) return false;
+    uint8_t buf[sizeof(FlashRecordHead) + RECORD_MAX_SIZE];
+    FlashRecordHead head;
+    head.version = version;
+    head.len = len;
+    head.crc = esp_rom_crc32_le(0, static_cast<const uint8_t*>(value), len);
 
-    nvs_close(m_nvs); // 关闭句柄
+    memcpy(buf, &head, sizeof(head));
+    memcpy(buf + sizeof(head), value, len);
+
+    return saveAsBlob(key, buf, sizeof(head) + len);
+}
 
+/**
+ * @brief 读取一条记录，版本、长度或CRC任一不符都视为无效
+ * 
+ * @param key 键
+ * @param version 期望的数据结构版本
+ * @param data_buf 读出数据的缓存区
+ * @param len 期望的数据长度
+ * 
+ * @return 记录存在且校验通过返回true，否则data_buf内容不可用
+ */
+bool Flash::readRecord(const char* key, uint16_t version, void* data_buf, size_t len) {
+    if (len > RECORD_MAX_SIZE) return false;
+
+    uint8_t buf[sizeof(FlashRecordHead) + RECORD_MAX_SIZE];
+    size_t bufLen = sizeof(buf);
+    if (!readAsBlob(key, buf, &bufLen)) return false;
+    if (bufLen != sizeof(FlashRecordHead) + len) return false;
+
+    FlashRecordHead head;
+    memcpy(&head, buf, sizeof(head));
+    if (head.version != version || head.len != len) return false;
+
+    const uint8_t* data = buf + sizeof(head);
+    if (esp_rom_crc32_le(0, data, len) != head.crc) return false;
+
+    memcpy(data_buf, data, len);
     return true;
 }
+
+/**
+ * @brief 开始批量写入，之后的saveAsBlob和saveRecord只写入不提交
+ */
+void Flash::beginBatch() {
+    m_batch++;
+}
+
+/**
+ * @brief 结束批量写入，最外层的commitBatch提交之前所有写入
+ * 
+ * @return 提交成功返回true，内层调用和未初始化时只结束批量
+ */
+bool Flash::commitBatch() {
+    if (m_batch == 0) return false;
+    if (--m_batch) return true;
+    if (!success) return false;
+
+    return nvs_commit(m_nvs) == ESP_OK;
+}
+
+/**
+ * @brief 映射只读配置分区，校验通过后可用findTable和getTable查表
+ * 
+ * @param label 分区名，见partitions.csv，内容由 tools/config_gen.py 生成
+ * 
+ * @return 分区存在且内容有效返回true
+ */
+bool Flash::mapConfig(const char* label) {
+    return m_config.map(label);
+}
+
+/**
+ * @brief 按ID和版本查表
+ * 
+ * @param id 表ID，见CONFIG_ID
+ * @param version 期望的表结构体版本
+ * @param len 输出表数据长度，可为空
+ * 
+ * @return 指向映射内存的只读指针，未映射、找不到或版本不符时返回nullptr
+ */
+const void* Flash::findTable(uint16_t id, uint16_t version, size_t* len) const {
+    return m_config.blob().find(id, version, len);
+}
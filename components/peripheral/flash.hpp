@@ -3,25 +3,54 @@
 
 #include "nvs_flash.h"
 #include "esp_err.h"
+#include "config_map.hpp"
 
 #define STORAGE_NAMESPACE "storage" // 定义一个存储命名空间
 
+/**
+ * @brief 带版本和校验的记录头，存储时位于数据之前
+ */
+struct FlashRecordHead
+{
+    uint16_t version = 0; // 数据结构版本
+    uint16_t len = 0; // 数据长度
+    uint32_t crc = 0; // 数据的CRC32
+}__attribute__((packed)); // 不进行字节对齐
+
 /**
  * @brief 用于存储操作的flash类
  * 
+ * @note init时打开NVS句柄并一直保持，析构时关闭；
+ *       beginBatch和commitBatch之间的写入只在commitBatch时提交一次，可嵌套。
+ *       同一时刻只应由一个任务使用。
+ *       只读配置区（出厂校准、曲线、滤波器系数等）经mapConfig映射后按ID查表，直接返回flash中的数据，
+ *       不经过NVS，不拷贝，可在任意任务中读取
 */
 class Flash {
     public:
+        static constexpr size_t RECORD_MAX_SIZE = 256; // 单条记录数据的最大长度
+
         Flash();
         ~Flash();
 
-        bool init(); // 初始化分区
+        bool init(); // 初始化分区并打开句柄
         bool saveAsBlob(const char* key, const void* value, size_t len); // 以blob存储
         bool readAsBlob(const char* key, void* data_buf, size_t* len); // 读取blob
+        bool saveRecord(const char* key, uint16_t version, const void* value, size_t len); // 存储带版本和CRC的记录
+        bool readRecord(const char* key, uint16_t version, void* data_buf, size_t len); // 读取并校验记录
+        void beginBatch(); // 开始批量写入，期间不提交
+        bool commitBatch(); // 结束批量写入，最外层时提交一次
+
+        bool mapConfig(const char* label = "config"); // 映射只读配置分区
+        const void* findTable(uint16_t id, uint16_t version, size_t* len = nullptr) const; // 按ID和版本查表
+        template <class T>
+        const T* getTable(uint16_t id, uint16_t version) const { return m_config.blob().get<T>(id, version); } // 按类型查表
 
     private:
         bool success;
-        nvs_handle_t m_nvs; // NVS操作句柄
+        nvs_handle_t m_nvs; // NVS操作句柄，init后一直打开
+        uint32_t m_batch; // 批量写入的嵌套层数
+        ConfigMap m_config; // 只读配置区的映射
 };
 
 #endif
@@ -1,4 +1,5 @@
 #include "gpio.hpp"
+#include "esp_intr_alloc.h"
 
 /**
  * @brief 创建GPIO类
@@ -68,3 +69,20 @@ bool GPIO::write(uint8_t pin) {
 
     return true;
 }
+
+/**
+ * @brief 为输入引脚注册中断处理函数，触发方式由构造时的int_type决定
+ * 
+ * @param handler 中断处理函数，需放在IRAM中
+ * @param arg 传给处理函数的参数
+ * 
+ * @note 首次调用时安装GPIO中断服务，之后各引脚共用
+ */
+bool GPIO::addIsr(gpio_isr_t handler, void* arg) {
+    if (!success || m_int_type == GPIO_INTR_DISABLE) return false;
+
+    esp_err_t err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return false; // 已安装时返回INVALID_STATE
+
+    return gpio_isr_handler_add(m_num, handler, arg) == ESP_OK;
+}
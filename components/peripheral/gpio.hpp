@@ -31,6 +31,7 @@ class GPIO {
         bool init();
 
         bool write(uint8_t pin);
+        bool addIsr(gpio_isr_t handler, void* arg); // 注册中断处理函数
 
     private:
         bool success;
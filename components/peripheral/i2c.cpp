@@ -37,7 +37,9 @@ bool I2C::init() {
 }
 
 bool I2C::write_byte_to_mem(uint8_t addr, uint8_t mem_addr, uint8_t data) {
-    i2c_cmd_handle_t cmd_link = i2c_cmd_link_create(); // 创建命令链
+    uint8_t link_buf[WRITE_LINK_SIZE]; // 命令链放在栈上，不使用堆
+    i2c_cmd_handle_t cmd_link = i2c_cmd_link_create_static(link_buf, sizeof(link_buf)); // 创建命令链
+    if (!cmd_link) return false;
     i2c_master_start(cmd_link); // 起始位
     i2c_master_write_byte(cmd_link, (addr << 1 | I2C_MASTER_WRITE), true); // 从机地址(左移一位或上0表示写)
     i2c_master_write_byte(cmd_link, mem_addr, true); // 寄存器地址
@@ -45,7 +47,7 @@ bool I2C::write_byte_to_mem(uint8_t addr, uint8_t mem_addr, uint8_t data) {
     i2c_master_stop(cmd_link); // 停止位
 
     esp_err_t err = i2c_master_cmd_begin(m_i2c_id, cmd_link, pdMS_TO_TICKS(10)); // 发送指令链
-    i2c_cmd_link_delete(cmd_link); // 清除指令链内存
+    i2c_cmd_link_delete_static(cmd_link); // 清除指令链
     if (err != ESP_OK) {
         return false;
     }
@@ -68,7 +70,9 @@ bool I2C::read_bytes_from_mem(uint8_t addr, uint8_t mem_addr, uint8_t* bytes_buf
         return true;
     }
 
-    i2c_cmd_handle_t cmd_link = i2c_cmd_link_create(); // 创建命令链
+    uint8_t link_buf[READ_LINK_SIZE]; // 命令链放在栈上，不使用堆
+    i2c_cmd_handle_t cmd_link = i2c_cmd_link_create_static(link_buf, sizeof(link_buf)); // 创建命令链
+    if (!cmd_link) return false;
     i2c_master_start(cmd_link); // 起始位
     i2c_master_write_byte(cmd_link, (addr << 1 | I2C_MASTER_WRITE), true); // 从机地址(左移一位或上1表示写)
     i2c_master_write_byte(cmd_link, mem_addr, true); // 寄存器地址
@@ -82,7 +86,7 @@ bool I2C::read_bytes_from_mem(uint8_t addr, uint8_t mem_addr, uint8_t* bytes_buf
     i2c_master_stop(cmd_link); // 停止位
 
     esp_err_t err = i2c_master_cmd_begin(m_i2c_id, cmd_link, pdMS_TO_TICKS(50)); // 发送指令链
-    i2c_cmd_link_delete(cmd_link); // 清除指令链内存
+    i2c_cmd_link_delete_static(cmd_link); // 清除指令链
     if (err != ESP_OK) {
         return false;
     }
@@ -13,6 +13,9 @@ class I2C {
         bool read_bytes_from_mem(uint8_t addr, uint8_t mem_addr, uint8_t* bytes_buf, size_t len); // 从指定寄存器开始读取len个字节
 
     private:
+        static constexpr size_t WRITE_LINK_SIZE = I2C_LINK_RECOMMENDED_SIZE(1); // 写寄存器命令链：一次起始
+        static constexpr size_t READ_LINK_SIZE = I2C_LINK_RECOMMENDED_SIZE(2); // 读寄存器命令链：起始加重复起始
+
         i2c_port_t m_i2c_id;
         int m_sda;
         int m_scl;
@@ -0,0 +1,102 @@
+#include "param_store.hpp"
+#include "esp_log.h"
+
+namespace {
+    constexpr const char* TAG = "Param"; // 日志标签
+}
+
+ParamStore::ParamStore(Flash& flash) :
+    m_flash(flash),
+    m_entries(),
+    m_num(0) {
+}
+
+ParamStore::~ParamStore() {
+}
+
+/**
+ * @brief 从flash读取所有参数到缓存，应在Flash::init之后调用
+ *
+ * @return 读取到有效记录的参数数，其余参数保持默认值
+ *
+ * @note 尚未写入的修改会被flash中的记录覆盖
+ */
+size_t ParamStore::load() {
+    size_t loaded = 0;
+    for (size_t i = 0; i < m_num; i++) {
+        Entry& e = m_entries[i];
+        e.loaded = m_flash.readRecord(e.key, e.version, e.data, e.len); // 失败时不修改缓存值
+        if (e.loaded) {
+            e.dirty = false;
+            loaded++;
+        }
+    }
+    return loaded;
+}
+
+/**
+ * @brief 把所有脏参数写入flash，整批只提交一次
+ *
+ * @return 全部写入并提交成功返回true
+ *
+ * @note 提交成功后才清除写入成功的参数的脏标志；写入或提交失败的参数保持为脏，可再次commit重试
+ */
+bool ParamStore::commit() {
+    if (!dirtyCount()) return true;
+
+    bool ok = true;
+    bool saved[MAX_PARAMS] = {}; // 已写入、等待提交的参数
+    m_flash.beginBatch();
+    for (size_t i = 0; i < m_num; i++) {
+        Entry& e = m_entries[i];
+        if (!e.dirty) continue;
+        saved[i] = m_flash.saveRecord(e.key, e.version, e.data, e.len);
+        if (!saved[i]) {
+            ESP_LOGE(TAG, "Save %s failed !", e.key);
+            ok = false;
+        }
+    }
+    if (!m_flash.commitBatch()) {
+        ESP_LOGE(TAG, "Commit failed !");
+        return false;
+    }
+
+    for (size_t i = 0; i < m_num; i++) {
+        if (saved[i]) m_entries[i].dirty = false;
+    }
+    return ok;
+}
+
+size_t ParamStore::dirtyCount() const {
+    size_t n = 0;
+    for (size_t i = 0; i < m_num; i++) {
+        if (m_entries[i].dirty) n++;
+    }
+    return n;
+}
+
+/**
+ * @brief 注册一个参数，由Param构造时调用
+ *
+ * @return 参数下标，已满时返回-1，该参数只存在于RAM中
+ */
+int ParamStore::_add(const char* key, uint16_t version, void* data, size_t len) {
+    if (m_num >= MAX_PARAMS) {
+        ESP_LOGE(TAG, "No slot for %s !", key);
+        return -1;
+    }
+    m_entries[m_num] = {key, version, data, len, false, false};
+    return m_num++;
+}
+
+void ParamStore::_markDirty(int index) {
+    if (index >= 0) m_entries[index].dirty = true;
+}
+
+bool ParamStore::_isLoaded(int index) const {
+    return index >= 0 && m_entries[index].loaded;
+}
+
+bool ParamStore::_isDirty(int index) const {
+    return index >= 0 && m_entries[index].dirty;
+}
@@ -0,0 +1,93 @@
+#ifndef PARAM_STORE_HPP
+#define PARAM_STORE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include "flash.hpp"
+
+/**
+ * @brief 建立在Flash之上的参数存储，参数值缓存在RAM中
+ *
+ * @note 每个参数对应一条带版本和CRC的记录（Flash::saveRecord），
+ *       读取直接返回缓存不访问flash，修改只标记脏，commit时把所有脏参数在一次提交中写入。
+ *       参数和存储都不做加锁，应由同一个任务使用
+ */
+class ParamStore {
+    public:
+        static constexpr size_t MAX_PARAMS = 16; // 最多注册的参数数
+
+        /**
+         * @brief 一个类型化的参数，构造时向存储注册，生命周期应不短于存储
+         *
+         * @param T 参数类型，需可平凡复制且不超过Flash::RECORD_MAX_SIZE
+         */
+        template <class T>
+        class Param {
+            static_assert(std::is_trivially_copyable<T>::value, "param must be trivially copyable");
+            static_assert(sizeof(T) <= Flash::RECORD_MAX_SIZE, "param too large");
+
+            public:
+                /**
+                 * @param store 所属的存储
+                 * @param key NVS键，不超过15个字符
+                 * @param version 数据结构版本，结构体变动时递增，旧记录读取时视为无效
+                 * @param def flash中没有有效记录时的默认值
+                 */
+                Param(ParamStore& store, const char* key, uint16_t version, const T& def = T{}) :
+                    m_store(store),
+                    m_value(def) {
+                    m_index = store._add(key, version, &m_value, sizeof(T));
+                }
+
+                Param(const Param&) = delete;
+                Param& operator=(const Param&) = delete;
+
+                const T& get() const { return m_value; } // 读取缓存值
+                operator const T&() const { return m_value; }
+
+                // 修改缓存值并标记为脏，commit时写入flash
+                void set(const T& value) {
+                    m_value = value;
+                    m_store._markDirty(m_index);
+                }
+
+                bool isLoaded() const { return m_store._isLoaded(m_index); } // 缓存值来自flash中的有效记录
+                bool isDirty() const { return m_store._isDirty(m_index); } // 有尚未写入的修改
+
+            private:
+                ParamStore& m_store;
+                T m_value;
+                int m_index; // 在存储中的下标，注册失败为-1
+        };
+
+        ParamStore(Flash& flash);
+        ~ParamStore();
+
+        size_t load(); // 从flash读取所有参数到缓存
+        bool commit(); // 写入所有脏参数，只提交一次
+        size_t dirtyCount() const; // 尚未写入的参数数
+
+    private:
+        // 注册的参数
+        struct Entry
+        {
+            const char* key;
+            uint16_t version;
+            void* data; // 指向Param中的缓存值
+            size_t len;
+            bool loaded; // 缓存值来自flash
+            bool dirty; // 有尚未写入的修改
+        };
+
+        Flash& m_flash;
+        Entry m_entries[MAX_PARAMS];
+        size_t m_num;
+
+        int _add(const char* key, uint16_t version, void* data, size_t len);
+        void _markDirty(int index);
+        bool _isLoaded(int index) const;
+        bool _isDirty(int index) const;
+};
+
+#endif
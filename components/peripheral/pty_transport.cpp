@@ -0,0 +1,155 @@
+#include "pty_transport.hpp"
+#include "freertos/task.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+    // 单调时钟（ms），用于被信号打断后重算剩余的等待时间
+    int64_t monotonicMs() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+    }
+}
+
+PtyTransport::PtyTransport() : m_fd(-1), m_path(""), m_baud(115200) {
+}
+
+PtyTransport::~PtyTransport() {
+    if (m_fd >= 0) close(m_fd);
+}
+
+/**
+ * @brief 创建伪终端并设置为原始模式，主端非阻塞
+ */
+bool PtyTransport::init() {
+    m_fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (m_fd < 0) return false;
+
+    if (grantpt(m_fd) != 0 || unlockpt(m_fd) != 0) {
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    termios tio;
+    if (tcgetattr(m_fd, &tio) == 0) {
+        cfmakeraw(&tio); // 不做行缓冲和字符转换，否则0x0A等字节会被改写
+        tcsetattr(m_fd, TCSANOW, &tio);
+    }
+
+    snprintf(m_path, sizeof(m_path), "%s", ptsname(m_fd));
+    return true;
+}
+
+const char* PtyTransport::getPath() const {
+    return m_path;
+}
+
+/**
+ * @brief 等待主端可读或可写
+ * 
+ * @param events POLLIN或POLLOUT
+ * @param timeout 超时时间（FreeRTOS的Tick），portMAX_DELAY为一直等待
+ * 
+ * @note 被信号打断（EINTR）时按剩余时间继续等待，不当作错误
+ *       从端已关闭时主端一直报POLLHUP，poll立即返回，此时睡到超时再返回false，否则接收任务会空转占满CPU；
+ *       一直等待时（如write）立即返回false，与串口没有接收方时相同，数据被丢弃而不阻塞发送任务
+ */
+bool PtyTransport::_poll(short events, TickType_t timeout) {
+    pollfd pfd = {m_fd, events, 0};
+    int ms = timeout == portMAX_DELAY ? -1 : (int)(timeout * portTICK_PERIOD_MS);
+    int64_t deadline = monotonicMs() + ms;
+
+    while (true) {
+        int n = poll(&pfd, 1, ms);
+        if (n > 0 && (pfd.revents & events)) return true;
+        if (n > 0) { // 只有POLLHUP/POLLERR
+            if (ms > 0) {
+                int64_t left = deadline - monotonicMs();
+                if (left > 0) vTaskDelay(pdMS_TO_TICKS(left));
+            }
+            return false;
+        }
+        if (n == 0 || errno != EINTR) return false;
+
+        if (ms > 0) {
+            int64_t left = deadline - monotonicMs();
+            ms = left > 0 ? (int)left : 0;
+        }
+    }
+}
+
+/**
+ * @brief 写入全部数据，对端读得慢时阻塞等待
+ */
+bool PtyTransport::write(const void* data, size_t data_len) {
+    if (m_fd < 0) return false;
+
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    while (data_len) {
+        ssize_t n = ::write(m_fd, src, data_len);
+        if (n > 0) {
+            src += n;
+            data_len -= n;
+        }
+        else if (n < 0 && errno == EINTR) continue; // 被信号打断，直接重试
+        else if (n < 0 && errno != EAGAIN) return false;
+        else if (!_poll(POLLOUT, portMAX_DELAY)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 读取数据，与Uart::read相同，timeout为0时非阻塞
+ * 
+ * @return 读到的字节数，出错返回-1
+ */
+int PtyTransport::read(void* dataBuff, size_t data_len, TickType_t timeout) {
+    if (m_fd < 0) return -1;
+
+    if (timeout && !_poll(POLLIN, timeout)) return 0;
+
+    ssize_t n = ::read(m_fd, dataBuff, data_len);
+    if (n < 0) return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+    return n;
+}
+
+/**
+ * @brief 等待数据到达，对应串口的UART_DATA事件
+ */
+RX_EVENT PtyTransport::waitRxEvent(TickType_t timeout) {
+    if (m_fd < 0) return RX_NONE;
+
+    return _poll(POLLIN, timeout) ? RX_DATA : RX_NONE;
+}
+
+void PtyTransport::flushInput() {
+    if (m_fd < 0) return;
+
+    tcflush(m_fd, TCIFLUSH);
+}
+
+bool PtyTransport::setBaud(uint32_t baud) {
+    m_baud = baud;
+    return true;
+}
+
+uint32_t PtyTransport::getBaud() const {
+    return m_baud;
+}
+
+/**
+ * @brief 伪终端写入即完成，无需等待
+ */
+bool PtyTransport::waitTxDone(TickType_t timeout) {
+    (void) timeout;
+    return m_fd >= 0;
+}
@@ -0,0 +1,39 @@
+#ifndef PTY_TRANSPORT_HPP
+#define PTY_TRANSPORT_HPP
+
+#include "freertos/FreeRTOS.h"
+#include "rx_event.hpp"
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief 伪终端传输层，在linux目标上代替串口，用于在主机上压测COMM
+ * 
+ * @note init后由getPath得到从端路径（如/dev/pts/3），上位机程序打开该路径即相当于接上串口
+ *       波特率只做记录，伪终端按内存速度收发
+ */
+class PtyTransport {
+    public:
+        PtyTransport();
+        ~PtyTransport();
+
+        bool init(); // 创建伪终端
+        const char* getPath() const; // 从端路径
+
+        bool write(const void* data, size_t data_len);
+        int read(void* dataBuff, size_t data_len, TickType_t timeout);
+        RX_EVENT waitRxEvent(TickType_t timeout);
+        void flushInput();
+        bool setBaud(uint32_t baud);
+        uint32_t getBaud() const;
+        bool waitTxDone(TickType_t timeout);
+
+    private:
+        int m_fd; // 主端文件描述符
+        char m_path[64]; // 从端路径
+        uint32_t m_baud; // 记录的波特率
+
+        bool _poll(short events, TickType_t timeout); // 等待主端可读或可写
+};
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef RX_EVENT_HPP
+#define RX_EVENT_HPP
+
+#include <cstdint>
+
+// 传输层接收事件，屏蔽具体驱动的事件类型
+enum RX_EVENT : uint8_t {
+    RX_NONE,     // 超时，没有事件
+    RX_DATA,     // 有数据到达
+    RX_OVERFLOW, // 接收溢出，数据已丢失
+    RX_OTHER,    // 其他驱动事件
+};
+
+#endif
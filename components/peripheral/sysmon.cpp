@@ -0,0 +1,321 @@
+#include "sysmon.hpp"
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <atomic>
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_heap_caps.h"
+#endif
+
+namespace {
+    constexpr const char* TAG = "SYSMON"; // 日志标签
+
+    // 登记项的状态
+    enum ENTRY_STATE : uint8_t {
+        ENTRY_FREE = 0,
+        ENTRY_RUNNING, // 任务运行中
+        ENTRY_EXITED, // 静态分配模式下任务已退出并挂起，栈和控制块等待回收
+        ENTRY_REAPING // 正在被某次createTask回收
+    };
+
+    // 登记的任务，由任务自己在入口处填入句柄，退出前注销，保证报告时句柄有效
+    struct TaskEntry {
+        uint8_t state;
+        TaskFunction_t fn;
+        void* arg;
+        const char* name;
+        uint32_t stack;
+        TaskHandle_t handle;
+        size_t offset; // 静态分配模式下栈在内存池中的偏移（字节）
+    };
+
+    TaskEntry entries[SYSMON::MAX_TASKS];
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if STATIC_ALLOC
+    constexpr int REAP_RETRIES = 10; // 内存池不足而有任务正在退出时，等待其挂起的最多次数（tick）
+
+    alignas(16) StackType_t pool[STATIC_TASK_POOL / sizeof(StackType_t)]; // 任务栈内存池
+    StaticTask_t tcbs[SYSMON::MAX_TASKS]; // 任务控制块，与entries一一对应
+
+    /**
+     * 回收已退出任务的栈和控制块，不持锁调用
+     * 退出的任务先挂起自己，这里确认它已不在任何核心上运行后再删除：
+     * 删除一个未运行的任务时FreeRTOS立即清理控制块，返回后内存即可复用，不依赖空闲任务
+     *
+     * @return 仍在退出途中（尚未挂起）的任务数
+     */
+    size_t reapExited() {
+        size_t pending = 0;
+        for (TaskEntry& e : entries) {
+            TaskHandle_t task = nullptr;
+            portENTER_CRITICAL(&lock);
+            if (e.state == ENTRY_EXITED) {
+                task = e.handle;
+                e.state = ENTRY_REAPING;
+            }
+            portEXIT_CRITICAL(&lock);
+            if (!task) continue;
+
+            bool suspended = eTaskGetState(task) == eSuspended; // 运行中的任务返回eRunning
+            if (suspended) vTaskDelete(task);
+            portENTER_CRITICAL(&lock);
+            e.state = suspended ? ENTRY_FREE : ENTRY_EXITED;
+            portEXIT_CRITICAL(&lock);
+            if (!suspended) pending++;
+        }
+        return pending;
+    }
+
+    /**
+     * 首次适配：在未回收的栈之间找一段足够长的空闲，持锁调用
+     *
+     * @return 偏移（字节），找不到返回SIZE_MAX
+     */
+    size_t findGap(size_t stack) {
+        size_t offset = 0;
+        while (offset + stack <= sizeof(pool)) {
+            size_t next = offset;
+            for (const TaskEntry& e : entries) {
+                if (e.state != ENTRY_FREE && e.offset < offset + stack && offset < e.offset + e.stack) {
+                    next = e.offset + e.stack; // 与该栈重叠，跳到它之后
+                    break;
+                }
+            }
+            if (next == offset) return offset;
+            offset = next;
+        }
+        return SIZE_MAX;
+    }
+#endif
+
+    std::atomic<bool> startupDone{false};
+    size_t freeAtStartup = 0;
+    std::atomic<uint32_t> allocs{0};
+    std::atomic<uint32_t> allocBytes{0};
+    std::atomic<uint32_t> lastAllocSize{0};
+    uint32_t reportPeriod = 0; // 报告周期（ms）
+
+    // 任务入口，登记句柄后进入真正的任务函数，任务函数返回时自动退出
+    void trampoline(void* arg) {
+        TaskEntry& entry = *static_cast<TaskEntry*>(arg);
+        portENTER_CRITICAL(&lock);
+        entry.handle = xTaskGetCurrentTaskHandle();
+        portEXIT_CRITICAL(&lock);
+
+        entry.fn(entry.arg);
+        SYSMON::exitTask();
+    }
+
+    void reportTask(void* arg) {
+        (void) arg;
+        while (true) {
+            vTaskDelay(pdMS_TO_TICKS(reportPeriod));
+            SYSMON::logReport();
+        }
+    }
+}
+
+#if CONFIG_HEAP_USE_HOOKS
+/**
+ * 堆分配钩子，每次分配成功后由堆实现调用，可能在中断中，只做原子计数
+ */
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+    (void) ptr;
+    (void) caps;
+    if (!startupDone.load(std::memory_order_relaxed)) return;
+    allocs.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    lastAllocSize.store(size, std::memory_order_relaxed);
+}
+
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void* ptr) {
+    (void) ptr;
+}
+#endif
+
+/**
+ * @brief 创建并登记一个绑定核心的任务
+ *
+ * @note STATIC_ALLOC模式下栈取自静态内存池（按16字节对齐，首次适配），控制块与登记项一一对应；
+ *       已退出任务的栈和控制块在这里回收复用
+ */
+bool SYSMON::createTask(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                        UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    TaskEntry* entry = nullptr;
+#if STATIC_ALLOC
+    stack = (stack + 15) & ~15u;
+    for (int retry = 0; ; retry++) {
+        size_t pending = reapExited();
+        portENTER_CRITICAL(&lock);
+        size_t offset = findGap(stack);
+        for (TaskEntry& e : entries) {
+            if (offset != SIZE_MAX && e.state == ENTRY_FREE) {
+                entry = &e;
+                *entry = {ENTRY_RUNNING, fn, arg, name, stack, nullptr, offset};
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&lock);
+        if (entry || !pending || retry >= REAP_RETRIES) break;
+        vTaskDelay(1); // 有任务正在退出，等它挂起后再回收
+    }
+#else
+    portENTER_CRITICAL(&lock);
+    for (TaskEntry& e : entries) {
+        if (e.state == ENTRY_FREE) {
+            entry = &e;
+            *entry = {ENTRY_RUNNING, fn, arg, name, stack, nullptr, 0};
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+#endif
+
+    if (!entry) {
+        ESP_LOGE(TAG, "No slot for task %s !", name);
+        return false;
+    }
+
+    TaskHandle_t task = nullptr;
+#if STATIC_ALLOC
+    task = xTaskCreateStaticPinnedToCore(trampoline, name, stack, entry, priority,
+                                         pool + entry->offset / sizeof(StackType_t), &tcbs[entry - entries], core);
+#else
+    if (xTaskCreatePinnedToCore(trampoline, name, stack, entry, priority, &task, core) != pdPASS) task = nullptr;
+#endif
+
+    if (!task) {
+        portENTER_CRITICAL(&lock);
+        entry->state = ENTRY_FREE;
+        portEXIT_CRITICAL(&lock);
+        return false;
+    }
+    if (handle) *handle = task;
+    return true;
+}
+
+/**
+ * @brief 注销并删除当前任务，代替vTaskDelete(NULL)
+ *
+ * @note STATIC_ALLOC模式下只挂起自己，栈和控制块由之后的createTask删除任务后回收
+ */
+void SYSMON::exitTask() {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    bool registered = false;
+    portENTER_CRITICAL(&lock);
+    for (TaskEntry& e : entries) {
+        if (e.state == ENTRY_RUNNING && e.handle == self) {
+            e.state = STATIC_ALLOC ? ENTRY_EXITED : ENTRY_FREE;
+            registered = true;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (STATIC_ALLOC && registered) {
+        while (true) vTaskSuspend(NULL);
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 标记启动完成，记录空闲堆作为基准，之后的堆分配会被计数
+ */
+void SYSMON::markStartup() {
+#if !CONFIG_IDF_TARGET_LINUX
+    freeAtStartup = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+#endif
+    startupDone.store(true, std::memory_order_release);
+}
+
+bool SYSMON::isStartupDone() {
+    return startupDone.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief 获取各登记任务的栈水位
+ *
+ * @param out 输出数组
+ * @param maxNum 输出数组长度
+ *
+ * @return 输出的任务数
+ */
+size_t SYSMON::getTasks(TaskStat* out, size_t maxNum) {
+    size_t n = 0;
+    portENTER_CRITICAL(&lock); // 持锁期间登记的任务不会退出，句柄有效
+    for (const TaskEntry& e : entries) {
+        if (n >= maxNum) break;
+        if (e.state != ENTRY_RUNNING || !e.handle) continue;
+        out[n].name = e.name;
+        out[n].stack = e.stack;
+        out[n].minFree = uxTaskGetStackHighWaterMark(e.handle) * sizeof(StackType_t);
+        n++;
+    }
+    portEXIT_CRITICAL(&lock);
+    return n;
+}
+
+/**
+ * @brief 获取堆使用情况
+ */
+HeapStat SYSMON::getHeap() {
+    HeapStat stat;
+#if !CONFIG_IDF_TARGET_LINUX
+    stat.freeNow = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    stat.minFree = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    stat.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+#endif
+    stat.freeAtStartup = freeAtStartup;
+    stat.allocs = allocs.load(std::memory_order_relaxed);
+    stat.allocBytes = allocBytes.load(std::memory_order_relaxed);
+    stat.lastAllocSize = lastAllocSize.load(std::memory_order_relaxed);
+    return stat;
+}
+
+/**
+ * @brief 输出一次堆和各任务栈水位的报告
+ */
+void SYSMON::logReport() {
+    HeapStat heap = getHeap();
+    ESP_LOGI(TAG, "heap free %u, at startup %u, min %u, largest block %u",
+             (unsigned)heap.freeNow, (unsigned)heap.freeAtStartup, (unsigned)heap.minFree, (unsigned)heap.largestBlock);
+
+#if CONFIG_HEAP_USE_HOOKS
+    if (heap.allocs)
+        ESP_LOGW(TAG, "%u allocations (%u bytes) after startup, last %u bytes",
+                 (unsigned)heap.allocs, (unsigned)heap.allocBytes, (unsigned)heap.lastAllocSize);
+#else
+    if (isStartupDone() && heap.freeNow < heap.freeAtStartup)
+        ESP_LOGW(TAG, "heap shrank by %u bytes after startup", (unsigned)(heap.freeAtStartup - heap.freeNow));
+#endif
+
+#if STATIC_ALLOC
+    size_t poolUsed = 0;
+    portENTER_CRITICAL(&lock);
+    for (const TaskEntry& e : entries) {
+        if (e.state != ENTRY_FREE) poolUsed += e.stack;
+    }
+    portEXIT_CRITICAL(&lock);
+    ESP_LOGI(TAG, "static task pool %u of %u", (unsigned)poolUsed, (unsigned)sizeof(pool));
+#endif
+
+    TaskStat tasks[MAX_TASKS];
+    size_t n = getTasks(tasks, MAX_TASKS);
+    for (size_t i = 0; i < n; i++) {
+        ESP_LOGI(TAG, "task %-10s stack %5u, min free %5u",
+                 tasks[i].name, (unsigned)tasks[i].stack, (unsigned)tasks[i].minFree);
+    }
+}
+
+/**
+ * @brief 启动周期报告任务，应在markStartup之前调用，任务创建本身不计入启动后的分配
+ *
+ * @param periodMs 报告周期（ms）
+ * @param priority 任务优先级，应为最低
+ * @param core 绑定的核心
+ */
+bool SYSMON::startReport(uint32_t periodMs, UBaseType_t priority, BaseType_t core) {
+    if (reportPeriod) return false;
+    reportPeriod = periodMs;
+    return createTask(reportTask, "sysmon", REPORT_TASK_STACK, nullptr, priority, NULL, core);
+}
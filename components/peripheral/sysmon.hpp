@@ -0,0 +1,69 @@
+#ifndef SYSMON_HPP
+#define SYSMON_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/**
+ * 任务创建和内存监视
+ * 所有任务经SYSMON::createTask创建并登记，用于报告各任务的栈水位；
+ * 编译时定义 STATIC_ALLOC=1 时任务栈和控制块取自静态内存池（xTaskCreateStaticPinnedToCore），不使用堆，
+ * 池大小由 STATIC_TASK_POOL 决定（字节），不足时createTask返回false；
+ * 应用应以static_assert检查所创建任务的栈之和不超过池大小（见main/demo.cpp），退出的任务的栈会被回收复用
+ *
+ * 启动完成后调用markStartup，之后的堆分配会被计数：
+ * 打开 CONFIG_HEAP_USE_HOOKS 时逐次统计分配次数和字节数，否则只能比较空闲堆大小的变化
+ */
+#ifndef STATIC_ALLOC
+#define STATIC_ALLOC 0
+#endif
+
+#ifndef STATIC_TASK_POOL
+#define STATIC_TASK_POOL (41 * 1024)
+#endif
+
+// 单个任务的栈使用情况
+struct TaskStat
+{
+    const char* name = nullptr;
+    uint32_t stack = 0; // 栈大小（字节）
+    uint32_t minFree = 0; // 运行以来栈的最小剩余（字节）
+};
+
+// 堆使用情况（字节）
+struct HeapStat
+{
+    size_t freeNow = 0; // 当前空闲
+    size_t freeAtStartup = 0; // markStartup时的空闲
+    size_t minFree = 0; // 开机以来的最小空闲
+    size_t largestBlock = 0; // 最大连续空闲块，远小于freeNow说明存在碎片
+    uint32_t allocs = 0; // 启动完成后的分配次数，需要CONFIG_HEAP_USE_HOOKS
+    uint32_t allocBytes = 0; // 启动完成后分配的总字节数，需要CONFIG_HEAP_USE_HOOKS
+    uint32_t lastAllocSize = 0; // 启动完成后最近一次分配的大小
+};
+
+namespace SYSMON {
+    constexpr size_t MAX_TASKS = 16; // 最多登记的任务数
+    constexpr uint32_t REPORT_TASK_STACK = 3072; // 报告任务栈大小
+
+    /**
+     * @brief 创建并登记一个绑定核心的任务，参数同xTaskCreatePinnedToCore
+     *
+     * @return 创建成功返回true
+     */
+    bool createTask(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                    UBaseType_t priority, TaskHandle_t* handle = NULL, BaseType_t core = tskNO_AFFINITY);
+    void exitTask(); // 注销并删除当前任务，由createTask创建的任务退出时调用
+
+    void markStartup(); // 标记启动完成，之后的堆分配视为异常
+    bool isStartupDone();
+
+    size_t getTasks(TaskStat* out, size_t maxNum); // 各登记任务的栈水位，返回任务数
+    HeapStat getHeap(); // 堆使用情况
+    void logReport(); // 用ESP_LOG输出一次报告，只用整数格式，本身不分配堆
+    bool startReport(uint32_t periodMs, UBaseType_t priority, BaseType_t core = tskNO_AFFINITY); // 周期输出报告
+}
+
+#endif
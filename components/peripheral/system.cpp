@@ -1,4 +1,6 @@
 #include "system.hpp"
+#include "esp_attr.h"
+#include "sdkconfig.h"
 
 // freertos毫秒计时任务
 void _time_task(int ms) { 
@@ -20,16 +22,125 @@ void delay_ms(int ms) {
  * @brief 速度控制类，类似ROS的用法
  * 
  * @param hz 频率
+ * @param policy 循环超时后的追赶策略
  */
-Rate::Rate(float hz) 
-    : m_hz(hz), xLastWakeTime(xTaskGetTickCount()), tick(pdMS_TO_TICKS(FREEROTS_RATE / hz)){
+Rate::Rate(float hz, RATE_POLICY policy) 
+    : m_hz(hz),
+      m_policy(policy),
+      m_timer(NULL),
+      m_started(false),
+      m_start(0),
+      m_fired(0),
+      m_consumed(0),
+      m_catch_up(false),
+      m_last(0),
+      xLastWakeTime(xTaskGetTickCount()),
+      tick(pdMS_TO_TICKS(FREEROTS_RATE / hz)) {
+    resetStats();
+
+    double period = hz > 0 ? 1e6 / hz : 1e6;
+    m_period = period < MIN_PERIOD_US ? MIN_PERIOD_US : (uint32_t)(period + 0.5);
+    if (tick < 1) tick = 1;
+
+    m_sem = xSemaphoreCreateBinaryStatic(&m_sem_buf);
+
+    esp_timer_create_args_t args = {};
+    args.callback = _onTimer;
+    args.arg = this;
+    args.name = "rate";
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+    args.dispatch_method = ESP_TIMER_ISR; // 在中断中直接唤醒，不经过esp_timer任务
+#else
+    args.dispatch_method = ESP_TIMER_TASK;
+#endif
+
+    if (esp_timer_create(&args, &m_timer) != ESP_OK) {
+        m_timer = NULL;
+    }
+}
+
+Rate::~Rate() {
+    if (m_timer) {
+        esp_timer_stop(m_timer);
+        esp_timer_delete(m_timer);
+    }
+    vSemaphoreDelete(m_sem);
 }
 
 /**
- * @brief 自动更新时间戳，休眠直到时间达标
+ * @brief 定时器回调，记录到期次数并唤醒sleep
+ */
+void IRAM_ATTR Rate::_onTimer(void* arg) {
+    Rate& self = *static_cast<Rate*>(arg);
+    self.m_fired.fetch_add(1, std::memory_order_release);
+
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(self.m_sem, &woken);
+    if (woken) esp_timer_isr_dispatch_need_yield();
+#else
+    xSemaphoreGive(self.m_sem);
+#endif
+}
+
+/**
+ * @brief 休眠直到下一个周期点
+ * 
+ * @note 调用时已有到期未消费的周期说明循环体超时：
+ *       RATE_SKIP丢弃所有错过的周期，等待下一个周期点；
+ *       RATE_BURST立即返回，之后的sleep继续立即返回直到补齐，积压超过MAX_BURST的部分丢弃
  */
 void Rate::sleep() {
-    vTaskDelayUntil(&xLastWakeTime, tick);
+    if (!m_started) { // 第一次sleep才开始计时，否则构造后的初始化耗时会被算作第一个周期超时
+        m_started = true;
+        xLastWakeTime = xTaskGetTickCount();
+        m_start = esp_timer_get_time();
+        m_last = m_start;
+        if (m_timer && esp_timer_start_periodic(m_timer, m_period) != ESP_OK) {
+            esp_timer_delete(m_timer);
+            m_timer = NULL;
+        }
+    }
+
+    if (!m_timer) { // 定时器不可用，退回节拍延时
+        vTaskDelayUntil(&xLastWakeTime, tick);
+        return;
+    }
+
+    uint32_t pending = m_fired.load(std::memory_order_acquire) - m_consumed;
+    if (pending && !m_catch_up) m_overruns++;
+
+    if (pending && m_policy == RATE_SKIP) {
+        m_missed += pending;
+        m_consumed += pending;
+        pending = 0;
+    }
+    else if (pending > MAX_BURST) {
+        m_missed += pending - MAX_BURST;
+        m_consumed += pending - MAX_BURST;
+        pending = MAX_BURST;
+    }
+
+    bool waited = !pending;
+    while (!pending) {
+        xSemaphoreTake(m_sem, portMAX_DELAY);
+        pending = m_fired.load(std::memory_order_acquire) - m_consumed;
+    }
+    m_consumed++;
+    m_catch_up = pending > 1;
+
+    int64_t now = esp_timer_get_time();
+    if (waited) { // 补周期时的滞后来自循环体超时，不计入唤醒抖动
+        int64_t late = now - (m_start + (int64_t)m_consumed * m_period);
+        m_jitter.record(late > 0 ? late : 0);
+    }
+
+    uint32_t interval = now - m_last;
+    m_last = now;
+    m_period_sum += interval;
+    m_period_cnt++;
+    if (interval < m_period_min) m_period_min = interval;
+    if (interval > m_period_max) m_period_max = interval;
 }
 
 /**
@@ -39,6 +150,45 @@ float Rate::getRate() const {
     return m_hz;
 }
 
+/**
+ * @brief 获取实际使用的周期，频率按微秒取整后可能与设置略有差别
+ */
+uint32_t Rate::getPeriodUs() const {
+    return m_period;
+}
+
+/**
+ * @brief 获取周期和唤醒抖动统计
+ */
+RateStats Rate::getStats() const {
+    RateStats stats;
+    stats.count = m_period_cnt;
+    stats.overruns = m_overruns;
+    stats.missed = m_missed;
+    if (m_period_cnt) {
+        stats.periodMin = m_period_min;
+        stats.periodMax = m_period_max;
+        stats.periodMean = (float)m_period_sum / m_period_cnt;
+    }
+    stats.jitterP50 = m_jitter.percentile(0.5f);
+    stats.jitterP99 = m_jitter.percentile(0.99f);
+    stats.jitterMax = m_jitter.max();
+    return stats;
+}
+
+/**
+ * @brief 清空统计
+ */
+void Rate::resetStats() {
+    m_period_sum = 0;
+    m_period_cnt = 0;
+    m_period_min = UINT32_MAX;
+    m_period_max = 0;
+    m_overruns = 0;
+    m_missed = 0;
+    m_jitter.reset();
+}
+
 // uint8转int16
 int16_t UINT8_2_INT16(uint8_t highByte, uint8_t lowByte) {
      /* 1. 先将高字节左移 8 位，并与低字节进行位或操作，得到一个无符号的 16 位值
@@ -1,8 +1,12 @@
 #ifndef SYSTEM_HPP
 #define SYSTEM_HPP
 
+#include <atomic>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "histogram.hpp"
 
 #define FREEROTS_RATE 1000 // freerots频率
 
@@ -13,21 +17,77 @@ void delay(int sec);
 // 毫秒级延时
 void delay_ms(int ms);
 
+// 循环超时后的追赶策略
+enum RATE_POLICY {
+    RATE_SKIP,  // 跳过错过的周期，等待下一个周期点，保持相位
+    RATE_BURST, // 立即连续补上错过的周期（最多MAX_BURST个），保持总次数，适合按固定dt积分的循环
+};
+
+// 循环频率统计（us）
+struct RateStats
+{
+    uint32_t count = 0; // 已完成的周期数
+    uint32_t overruns = 0; // 循环体超过一个周期的次数
+    uint32_t missed = 0; // 被跳过的周期数
+    uint32_t periodMin = 0; // 相邻两次sleep返回的最小间隔
+    uint32_t periodMax = 0; // 最大间隔
+    float periodMean = 0.0f; // 平均间隔
+    uint32_t jitterP50 = 0; // 唤醒时刻相对计划周期点的滞后
+    uint32_t jitterP99 = 0;
+    uint32_t jitterMax = 0;
+};
+
 /**
  * @brief 速度控制类，类似ROS的用法
  * 
- * @param hz 频率
+ * @param hz 频率，不受FreeRTOS节拍限制，周期按微秒取整
+ * @param policy 循环超时后的追赶策略
+ * 
+ * @note 由esp_timer周期定时器驱动，定时器在第一次sleep时启动，构造后到进入循环之间的初始化不算超时；
+ *       周期点固定在第一次sleep时刻的整数倍上，不随循环耗时漂移。
+ *       只允许一个任务调用sleep；统计可由其他任务读取，可能相差一次记录
  */
 class Rate {
     public:
-        Rate(float hz);
+        Rate(float hz, RATE_POLICY policy = RATE_SKIP);
+        ~Rate();
+        Rate(const Rate&) = delete;
+        Rate& operator=(const Rate&) = delete;
 
         void sleep();
         float getRate() const;
+        uint32_t getPeriodUs() const; // 实际使用的周期（us）
+        RateStats getStats() const; // 周期和抖动统计
+        void resetStats(); // 清空统计，应在sleep的任务中调用
     private:
+        static constexpr uint32_t MIN_PERIOD_US = 50; // esp_timer周期定时器的最小周期
+        static constexpr uint32_t MAX_BURST = 4; // BURST策略一次最多补上的周期数
+
         float m_hz;
-        TickType_t xLastWakeTime;
+        RATE_POLICY m_policy;
+        uint32_t m_period; // 周期（us）
+        esp_timer_handle_t m_timer;
+        SemaphoreHandle_t m_sem; // 定时器到期信号
+        StaticSemaphore_t m_sem_buf;
+        bool m_started; // 已调用过sleep，定时器已启动
+        int64_t m_start; // 定时器启动时刻，第k个周期点为 m_start + k * m_period
+        std::atomic<uint32_t> m_fired; // 定时器到期次数，只由定时器回调写入
+        uint32_t m_consumed; // 已消费的周期数，只由sleep写入
+        bool m_catch_up; // BURST策略正在补周期
+
+        int64_t m_last; // 上一次sleep返回的时刻
+        int64_t m_period_sum; // 间隔之和
+        uint32_t m_period_cnt;
+        uint32_t m_period_min;
+        uint32_t m_period_max;
+        uint32_t m_overruns;
+        uint32_t m_missed;
+        LatencyHist m_jitter; // 唤醒滞后分布
+
+        TickType_t xLastWakeTime; // 定时器创建失败时退回节拍延时
         int tick;
+
+        static void _onTimer(void* arg); // 定时器回调
 };
 
 // uint8转int16
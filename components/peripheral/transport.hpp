@@ -0,0 +1,27 @@
+#ifndef TRANSPORT_HPP
+#define TRANSPORT_HPP
+
+#include "sdkconfig.h"
+#include "rx_event.hpp"
+
+/**
+ * 编译期选择COMM使用的传输层，目标板上为串口，linux目标上为伪终端
+ * 
+ * 传输层需要提供：
+ *   bool write(const void* data, size_t len);
+ *   int read(void* buf, size_t len, TickType_t timeout);
+ *   RX_EVENT waitRxEvent(TickType_t timeout);
+ *   void flushInput();
+ *   bool setBaud(uint32_t baud);
+ *   uint32_t getBaud() const;
+ *   bool waitTxDone(TickType_t timeout);
+ */
+#if CONFIG_IDF_TARGET_LINUX
+#include "pty_transport.hpp"
+using Transport = PtyTransport;
+#else
+#include "uart.hpp"
+using Transport = Uart;
+#endif
+
+#endif
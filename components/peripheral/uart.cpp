@@ -1,8 +1,8 @@
 #include "uart.hpp"
 
 // 构造函数
-Uart::Uart(uart_port_t uart_id, int tx_pin, int rx_pin)
-    : m_uart_id(uart_id), m_tx_pin(tx_pin), m_rx_pin(rx_pin), success(false) {
+Uart::Uart(uart_port_t uart_id, int tx_pin, int rx_pin, const UartConfig& config)
+    : m_uart_id(uart_id), m_tx_pin(tx_pin), m_rx_pin(rx_pin), m_config(config), success(false), m_event_queue(NULL) {
 }
 
 // 析构函数
@@ -15,12 +15,12 @@ Uart::~Uart() {
 bool Uart::init() {
     // 将初始化参数传入结构体
     uart_config_t uart_config = {
-        .baud_rate = 115200,
+        .baud_rate = m_config.baud_rate,
         .data_bits = UART_DATA_8_BITS,
         .parity = UART_PARITY_DISABLE,
         .stop_bits = UART_STOP_BITS_1,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        .rx_flow_ctrl_thresh = 0,
+        .flow_ctrl = m_config.flow_ctrl,
+        .rx_flow_ctrl_thresh = m_config.rx_flow_ctrl_thresh,
     };
     // 设置参数
     esp_err_t err = uart_param_config(m_uart_id, &uart_config);
@@ -29,16 +29,13 @@ bool Uart::init() {
         return false;
     }
 
-    err = uart_set_pin(m_uart_id, m_tx_pin, m_rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE); // 配置引脚
+    err = uart_set_pin(m_uart_id, m_tx_pin, m_rx_pin, m_config.rts_pin, m_config.cts_pin); // 配置引脚
 
     if (err != ESP_OK) {
         return false;
     }
 
-    const int uart_rx_buffer_size = 1024; // 接受缓冲区
-    const int uart_tx_buffer_size = 1024; // 发送缓冲区
-
-    err = uart_driver_install(m_uart_id, uart_rx_buffer_size, uart_tx_buffer_size, 0, NULL, 0);
+    err = uart_driver_install(m_uart_id, m_config.rx_buffer_size, m_config.tx_buffer_size, EVENT_QUEUE_SIZE, &m_event_queue, 0); // 安装驱动并创建事件队列
 
     if (err != ESP_OK) {
         return false;
@@ -63,45 +60,29 @@ bool Uart::write(const void* data, size_t data_len) {
         return true;
 }
 
-// 重构的类似printf的串口打印功能
+/**
+ * @brief 类似printf的串口打印功能，在栈上格式化，不使用堆
+ * 
+ * @return 发送成功返回true，超过PRINTF_BUF_SIZE被截断时仍发送截断后的内容并返回false
+ */
 bool Uart::printf(const char* fmt, ...) {
     if (!success) {
         return false;
     }
 
-    // 初始化可变参数列表
+    char buffer[PRINTF_BUF_SIZE];
+
     va_list args;
     va_start(args, fmt);
+    int len = vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args); // 清理可变参数列表
 
-    /* 
-    第一次调用 vsnprintf 来确定需要的缓冲区大小
-    通过传入 nullptr 和 0 大小，vsnprintf 不会写入任何东西，
-    但会返回格式化后字符串的长度（不包括末尾的 '\0'）
-    注意：需要一个 va_list 的副本，因为 vsnprintf 可能会修改它 
-    */
-    va_list args_copy;
-    va_copy(args_copy, args);
-    int len = vsnprintf(nullptr, 0, fmt, args_copy);
-    va_end(args_copy);
-
-    if (len < 0) {
-        // 如果出错，清理并返回失败
-        va_end(args);
+    if (len < 0) return false;
+    if ((size_t)len >= sizeof(buffer)) { // 截断
+        write(buffer, sizeof(buffer) - 1);
         return false;
     }
-
-    /* 
-    创建一个足够大的缓冲区来存放格式化后的字符串
-    大小为 len + 1，为末尾的 '\0' 留出空间 
-    */
-    std::vector<char> buffer(len + 1);
-
-    // 第二次调用 vsnprintf，这次真正地将内容写入缓冲区
-    vsnprintf(buffer.data(), buffer.size(), fmt, args);
-
-    va_end(args); // 清理可变参数列表
-
-    return write(buffer.data(), len); // 发送
+    return write(buffer, len); // 发送
 }
 
 /**
@@ -118,3 +99,113 @@ int Uart::read(void* dataBuff, size_t data_len, TickType_t timeout) {
 
     return uart_read_bytes(m_uart_id, dataBuff, data_len, timeout);
 }
+
+/**
+ * @brief 设置接收中断的触发条件，FIFO中数据达到fullThresh字节，或线路空闲timeout个符号时间后，
+ *        驱动搬运数据并向事件队列发送UART_DATA事件
+ * 
+ * @param fullThresh 接收FIFO满阈值（字节），越小响应越快，中断越频繁
+ * @param timeout 接收超时（符号时间，1个符号约为1字节的传输时间），用于把不足阈值的尾部数据及时送出
+ */
+bool Uart::setRxThreshold(int fullThresh, uint8_t timeout) {
+    if (!success) return false;
+
+    if (uart_set_rx_full_threshold(m_uart_id, fullThresh) != ESP_OK) return false;
+    if (uart_set_rx_timeout(m_uart_id, timeout) != ESP_OK) return false;
+
+    return true;
+}
+
+/**
+ * @brief 等待一个驱动事件
+ * 
+ * @param event 收到的事件
+ * @param timeout 超时时间（FreeRTOS的Tick）
+ * 
+ * @return 超时内收到事件返回true
+ * 
+ * @note 初始化失败时不会有事件，等满超时再返回false，否则循环等待事件的接收任务会空转
+ */
+bool Uart::waitEvent(uart_event_t& event, TickType_t timeout) {
+    if (!success) {
+        vTaskDelay(timeout);
+        return false;
+    }
+
+    return xQueueReceive(m_event_queue, &event, timeout) == pdTRUE;
+}
+
+/**
+ * @brief 等待一个驱动事件并归类为接收事件
+ * 
+ * @param timeout 超时时间（FreeRTOS的Tick）
+ */
+RX_EVENT Uart::waitRxEvent(TickType_t timeout) {
+    uart_event_t event;
+    if (!waitEvent(event, timeout)) return RX_NONE;
+
+    switch (event.type) {
+        case UART_DATA:
+            return RX_DATA;
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            return RX_OVERFLOW;
+        default:
+            return RX_OTHER;
+    }
+}
+
+/**
+ * @brief 清空接收缓冲区和事件队列，用于FIFO或缓冲区溢出后的恢复
+ */
+void Uart::flushInput() {
+    if (!success) return;
+
+    uart_flush_input(m_uart_id);
+    xQueueReset(m_event_queue);
+}
+
+QueueHandle_t Uart::getEventQueue() const {
+    return m_event_queue;
+}
+
+/**
+ * @brief 运行时切换波特率，调用前应先用waitTxDone等待已排队的数据以旧波特率发完
+ * 
+ * @param baud 新波特率
+ */
+bool Uart::setBaud(uint32_t baud) {
+    if (!success) return false;
+
+    if (uart_set_baudrate(m_uart_id, baud) != ESP_OK) return false;
+
+    m_config.baud_rate = baud;
+    return true;
+}
+
+/**
+ * @brief 获取当前波特率
+ */
+uint32_t Uart::getBaud() const {
+    return m_config.baud_rate;
+}
+
+/**
+ * @brief 等待发送缓冲区和FIFO中的数据全部发出
+ * 
+ * @param timeout 超时时间（FreeRTOS的Tick）
+ */
+bool Uart::waitTxDone(TickType_t timeout) {
+    if (!success) return false;
+
+    return uart_wait_tx_done(m_uart_id, timeout) == ESP_OK;
+}
+
+/**
+ * @brief 启用或关闭内部回环，启用后发出的数据直接进入本串口的接收端
+ */
+bool Uart::setLoopBack(bool enable) {
+    if (!success) return false;
+
+    return uart_set_loop_back(m_uart_id, enable) == ESP_OK;
+}
@@ -2,11 +2,28 @@
 #define UART_HPP
 
 #include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "rx_event.hpp"
 #include <cstdint>
 #include <cstdio>
 #include <cstdarg>
 #include <cstring>
-#include <vector>
+
+/**
+ * @brief 串口配置，默认115200波特率、无流控
+ */
+struct UartConfig
+{
+    int baud_rate = 115200; // 波特率
+    int rx_buffer_size = 1024; // 驱动接收缓冲区
+    int tx_buffer_size = 1024; // 驱动发送缓冲区，为0时发送阻塞直到写入FIFO
+    uart_hw_flowcontrol_t flow_ctrl = UART_HW_FLOWCTRL_DISABLE; // 硬件流控
+    uint8_t rx_flow_ctrl_thresh = 0; // 接收FIFO达到该字节数时拉高RTS，启用RTS流控时有效
+    int rts_pin = UART_PIN_NO_CHANGE; // RTS引脚
+    int cts_pin = UART_PIN_NO_CHANGE; // CTS引脚
+};
 
 class Uart {
     public:
@@ -14,7 +31,8 @@ class Uart {
         Uart ( 
             uart_port_t uart_id, //外设UART号
             int tx_pin, // 发送引脚
-            int rx_pin  // 接受引脚
+            int rx_pin, // 接受引脚
+            const UartConfig& config = UartConfig() // 波特率、缓冲区及流控配置
         );
 
         // 析构函数
@@ -31,12 +49,41 @@ class Uart {
 
         // 读
         int read(void* dataBuff, size_t data_len, TickType_t timeout);
+
+        // 设置接收FIFO满阈值（字节）和接收超时（符号时间），决定数据多快通知到事件队列
+        bool setRxThreshold(int fullThresh, uint8_t timeout);
+
+        // 等待一个驱动事件
+        bool waitEvent(uart_event_t& event, TickType_t timeout);
+
+        // 等待一个接收事件，驱动事件归类为RX_EVENT，供COMM等与驱动无关的上层使用
+        RX_EVENT waitRxEvent(TickType_t timeout);
+
+        // 清空接收缓冲区，用于溢出后的恢复
+        void flushInput();
+
+        QueueHandle_t getEventQueue() const;
+
+        // 运行时切换波特率
+        bool setBaud(uint32_t baud);
+        uint32_t getBaud() const;
+
+        // 等待发送缓冲区中的数据全部发出
+        bool waitTxDone(TickType_t timeout);
+
+        // 内部回环，TX直接连到RX，用于无外部连线的吞吐测试
+        bool setLoopBack(bool enable);
         
     private:
+        static constexpr int EVENT_QUEUE_SIZE = 16; // 驱动事件队列长度
+        static constexpr size_t PRINTF_BUF_SIZE = 256; // printf单次输出的最大长度（含结尾'\0'）
+
         uart_port_t m_uart_id;
         int m_tx_pin;
         int m_rx_pin;
+        UartConfig m_config;
         bool success;
+        QueueHandle_t m_event_queue; // 驱动事件队列
 
 };
 
@@ -0,0 +1,59 @@
+#include "adc_stream.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+/**
+ * 连续采样测试：ADC1的两个通道（电池分压、电流检测）合计20kHz扫描，
+ * 每帧在回调中求各通道均值，主循环每秒打印均值、实际采样率和采样任务的CPU占用
+ */
+const adc_channel_t channels[] = {ADC_CHANNEL_0, ADC_CHANNEL_1}; // 电池电压，电流
+AdcStream adcStream(ADC_UNIT_1, channels, 2);
+
+struct ChannelMean
+{
+    std::atomic<uint32_t> mean[2]; // 最近一帧的均值
+    std::atomic<int64_t> busyUs; // 回调累计耗时
+};
+ChannelMean result;
+
+/* 每帧调用一次，只做求和 */
+void onBatch(const AdcBatch& batch, void* arg) {
+    ChannelMean& out = *static_cast<ChannelMean*>(arg);
+    int64_t t0 = esp_timer_get_time();
+    for (size_t c = 0; c < batch.channels; c++) {
+        uint32_t sum = 0;
+        for (uint16_t i = 0; i < batch.count[c]; i++) sum += batch.data[c][i];
+        if (batch.count[c]) out.mean[c].store(sum / batch.count[c], std::memory_order_relaxed);
+    }
+    out.busyUs.fetch_add(esp_timer_get_time() - t0, std::memory_order_relaxed);
+}
+
+void demo(void *pvParameters) {
+    (void) pvParameters;
+
+    if (!adcStream.init() || !adcStream.start(onBatch, &result, 5, 0)) {
+        ESP_LOGE("ADC", "AdcStream start failed !");
+        vTaskDelete(NULL);
+    }
+    ESP_LOGI("ADC", "%lu Hz per channel", (unsigned long)adcStream.getChannelHz());
+
+    AdcStreamStats last = adcStream.getStats();
+    int64_t lastBusy = 0;
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        AdcStreamStats now = adcStream.getStats();
+        int64_t busy = result.busyUs.load(std::memory_order_relaxed);
+        ESP_LOGI("ADC", "bat %lu cur %lu  %lu samples/s  frames %lu overflows %lu invalid %lu  callback %.2f%% CPU",
+            (unsigned long)result.mean[0].load(), (unsigned long)result.mean[1].load(),
+            (unsigned long)(now.samples - last.samples), (unsigned long)(now.frames - last.frames),
+            (unsigned long)now.overflows, (unsigned long)now.invalid, (busy - lastBusy) / 10000.0);
+        last = now;
+        lastBusy = busy;
+    }
+}
+
+extern "C" void app_main(void) {
+    xTaskCreatePinnedToCore(demo, "demo", 4096, NULL, 1, NULL, 1);
+}
@@ -48,7 +48,7 @@ namespace UTILS {
         int mean[6]; // 存储平均值
         int temp[3]; // 辅助索引存储
         double lsb = PARAMS::ACCEL_LSB;
-        const std::string tag[6] = {
+        const char* const tag[6] = {
             "X+", "X-", "Y+", "Y-", "Z+", "Z-"
         };
 
@@ -62,7 +62,7 @@ namespace UTILS {
         int tempIndex = 0;
         int sign = 1;
         for (int i = 0; i < 6; i++) {
-            ESP_LOGI("AccelCali", "Pose: %s", tag[i].c_str());
+            ESP_LOGI("AccelCali", "Pose: %s", tag[i]);
             for (int j = 0; j < 500; j++) {
                 if (!icm20948.readAccel(buf)) return false;
                 temp[0] = buf.x;
@@ -0,0 +1,101 @@
+#include "main.hpp"
+
+/*实例化化各外设*/
+UartConfig uartConfig = [] {
+    UartConfig config;
+    config.rx_buffer_size = 4096; // 高波特率下加大驱动缓冲区
+    config.tx_buffer_size = 4096;
+    return config;
+}();
+Uart uart(UART_NUM_1, 17, 18, uartConfig); // 实例化串口，以115200启动，由上位机协商提速
+COMM comm(uart); // 实例化通讯
+
+/* 本链路上使用的消息 */
+using Msgs = MsgList<RoBoCmd>;
+
+/* 指令邮箱，接收任务写入，控制循环无锁读取最新指令 */
+CmdMailbox mailbox(comm);
+
+/* 创建RTOS任务函数 */ 
+void demo(void *pvParameters) {
+    (void) pvParameters; // 告诉编译器我知道这个没有别警告我
+
+    /* 初始化串口 */
+    if (uart.init()) {
+        ESP_LOGI("UART", "UART Init !");
+    }
+    else {
+        ESP_LOGE("UART", "UART Init Fail !");
+    }
+
+    /* 收满一个帧头即通知，线路空闲2个字节时间就把尾部数据送出 */
+    uart.setRxThreshold(sizeof(FrameHead), 2);
+
+    /* 允许上位机把链路提升到3Mbaud */
+    comm.setMaxBaud(3000000);
+
+    /* 启动接收任务，优先级高于本任务 */
+    comm.startRxTask(mailbox, Msgs{}, 5);
+
+    /* 启动发送任务，链路饱和时用新反馈覆盖未发出的旧反馈 */
+    comm.startTxTask(2, tskNO_AFFINITY, TX_COALESCE);
+
+    /* 初始化任务循环控制类 */
+    const float hz = 500;
+    Rate rate(hz);
+    const int64_t CMD_TIMEOUT = 100000; // 指令超过100ms未更新视为失联（us）
+
+    RoBoFeedBack feedback;
+    StampedCmd cmd, queued;
+    uint32_t cmdNum = 0;
+    uint8_t mode2 = 0;
+    uint32_t modeChanges = 0;
+    int cnt = 0;
+    while (1)
+    {
+        /* 常数时间读取最新指令，过期则回到安全状态 */
+        cmdNum = mailbox.latest(cmd);
+        bool stale = !cmdNum || esp_timer_get_time() - cmd.stamp > CMD_TIMEOUT;
+        feedback.status = stale ? 0 : cmd.cmd.mode1;
+
+        /* 模式切换不能因为最新值被覆盖而丢失，从按序队列中逐条处理 */
+        while (mailbox.pop(queued)) {
+            if (queued.cmd.mode2 != mode2) {
+                mode2 = queued.cmd.mode2;
+                modeChanges++;
+            }
+        }
+
+        /* 以固定频率发送反馈，不会被串口阻塞 */
+        comm.uartSendPack(feedback);
+
+        rate.sleep(); // 控制循环频率
+        if (++cnt < hz) continue;
+        cnt = 0;
+
+        /* 打印接收延迟 */
+        RxLatency lat = comm.getRxLatency();
+        ESP_LOGI("RxLatency", "cmd: %lu  last: %lu us  avg: %lu us  max: %lu us  overflow: %lu",
+            (unsigned long)cmdNum, (unsigned long)lat.last,
+            (unsigned long)(lat.cnt ? lat.sum / lat.cnt : 0), (unsigned long)lat.max,
+            (unsigned long)comm.getRxOverflow());
+        ESP_LOGI("Cmd", "mode changes: %lu  queue dropped: %lu  crc errors: %lu  duplicate: %lu  stale: %lu",
+            (unsigned long)modeChanges, (unsigned long)mailbox.getQueueDropped(), (unsigned long)comm.getRxCrcErrors(),
+            (unsigned long)comm.getRxDuplicate(), (unsigned long)comm.getRxStale());
+        ESP_LOGI("Link", "baud: %lu  fallback: %lu", (unsigned long)uart.getBaud(), (unsigned long)comm.getBaudFallback());
+        TxStats tx = comm.getTxStats();
+        ESP_LOGI("Tx", "frames: %lu  dropped: %lu  coalesced: %lu",
+            (unsigned long)tx.frames, (unsigned long)tx.dropped, (unsigned long)tx.coalesced);
+
+        /* 各阶段延迟分布发给上位机，定位超出控制延迟预算的阶段 */
+        LatencyReport report = comm.getLatencyReport();
+        comm.sendMsg(report);
+        ESP_LOGI("Latency", "p99 rx: %lu  proc: %lu  tx: %lu us  rtt: %lu us  drift: %.1f ppm",
+            (unsigned long)report.rx.p99, (unsigned long)report.proc.p99, (unsigned long)report.tx.p99,
+            (unsigned long)report.rtt, report.drift);
+    }
+}
+
+extern "C" void app_main(void) {
+    xTaskCreate(demo, "demo", 4096, NULL, 1, NULL); // 创建RTOS任务
+}
@@ -47,7 +47,7 @@ namespace UTILS {
         int mean[6]; // 存储平均值
         int temp[3]; // 辅助索引存储
         double lsb = PARAMS::ACCEL_LSB;
-        const std::string tag[6] = {
+        const char* const tag[6] = {
             "X+", "X-", "Y+", "Y-", "Z+", "Z-"
         };
 
@@ -61,7 +61,7 @@ namespace UTILS {
         int tempIndex = 0;
         int sign = 1;
         for (int i = 0; i < 6; i++) {
-            ESP_LOGI("AccelCali", "Pose: %s", tag[i].c_str());
+            ESP_LOGI("AccelCali", "Pose: %s", tag[i]);
             for (int j = 0; j < 500; j++) {
                 if (!icm20948.readAccel(buf)) {
                     ESP_LOGE("AccelCail", "dsiconnection !");
@@ -144,7 +144,8 @@ void demo(void *pvParameters) {
     if (!UTILS::caliGyro(rawGyroBias)) ESP_LOGE("GyroCali", "GyroCali Fail !"); // 陀螺仪零偏校准
     if (!UTILS::caliAccel(rawAccelBias, rawAccelGain)) ESP_LOGE("AccelCali", "AccelCali Fail !"); // 加速度计校准
 
-    /* 存入NVS */
+    /* 存入NVS，三个键一次提交 */
+    flash_nvs.beginBatch();
     if(flash_nvs.saveAsBlob("rawGyroBias", &rawGyroBias, sizeof(rawGyroBias)))
         ESP_LOGI("NVS", "GyroBias saved in key rawGyroBias !");
     else
@@ -157,6 +158,7 @@ void demo(void *pvParameters) {
         ESP_LOGI("NVS", "AccelGain saved in key rawAccelGain !");
     else
         ESP_LOGI("NVS", "AccelGain save failed !");
+    if (!flash_nvs.commitBatch()) ESP_LOGE("NVS", "NVS commit failed !");
 
     /* 初始化任务循环控制类 */
     Rate rate(1);
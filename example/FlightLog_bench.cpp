@@ -0,0 +1,142 @@
+#include <atomic>
+#include "flight_log.hpp"
+#include "histogram.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+/**
+ * 黑匣子写入测试：先按固定频率写入，看预擦除能否跟上、有无丢弃，再不限速写入测持续吞吐，
+ * 报告单页写入和单扇区擦除的最坏耗时，以及擦写期间核心1被拖住的时间：
+ *   push  - 生产者单次push()的耗时，push不访问flash，超过几us即为cache被关闭造成的停顿
+ *   loop  - 核心1上与黑匣子无关的忙循环相邻两次迭代的间隔，代表采集和融合看到的停顿
+ *
+ * 芯片上覆盖main/demo.cpp运行，对比sdkconfig中CONFIG_SPI_FLASH_AUTO_SUSPEND开关的结果；
+ * linux目标上 idf.py -DHOST_APP=example/FlightLog_bench.cpp build，分区由IDF以文件模拟，
+ * 没有cache停顿，只反映代码路径的开销，擦写耗时和停顿以芯片上的结果为准
+ *
+ * 主机结果（单核x86-64，g++ -O2，FreeRTOS换成std::thread、分区换成普通文件，没有优先级，
+ * push和loop的最大值是线程被操作系统切走的时间，不是flash停顿）：
+ *   200Hz: records 999 dropped 0 pages 125  6399 B/s  sync erases 0
+ *     write p99 95 max 157 us  erase p99 16 max 16 us  backlog max 1 pages  errors 0
+ *     push p99 2303 max 7133 us  loop p99 1 max 1651 us
+ *   1kHz: records 4998 dropped 0 pages 630  32246 B/s  sync erases 0
+ *     write p99 159 max 571 us  erase p99 16 max 16 us  backlog max 2 pages  errors 0
+ *     push p99 2303 max 13806 us  loop p99 1 max 1784 us
+ *   unlimited: records 665904 dropped 1626 pages 83894  4292800 B/s  sync erases 0
+ *     write p99 55 max 21718 us  erase p99 12 max 2518 us  backlog max 8 pages  errors 0
+ *     push p99 10 max 21751 us  loop p99 1 max 1873 us
+ */
+FlightLog flightLog; // 黑匣子，写入flightlog分区
+
+namespace BENCH {
+    constexpr int64_t BURST_US = 2000; // 核心1忙循环每个tick连续运行的时间
+    std::atomic<bool> looping(false); // 忙循环任务在测量
+    LatencyHist loopGap; // 忙循环相邻迭代的间隔，只由忙循环任务记录
+}
+
+/* 输出一个阶段的统计 */
+void report(const char* phase, const FlightLogStats& from, const FlightLogStats& to, int64_t us,
+    const LatencyHist& push, const LatencyHist& loop) {
+    uint32_t pages = to.pages - from.pages;
+    ESP_LOGI("Bench", "%s: records %lu dropped %lu pages %lu  %lu B/s  sync erases %lu",
+        phase, (unsigned long)(to.records - from.records), (unsigned long)(to.dropped - from.dropped),
+        (unsigned long)pages, (unsigned long)(pages * FlightLog::PAGE_SIZE * 1000000LL / us),
+        (unsigned long)(to.syncErases - from.syncErases));
+    ESP_LOGI("Bench", "  write p99 %lu max %lu us  erase p99 %lu max %lu us  backlog max %lu pages  errors %lu",
+        (unsigned long)to.writeP99, (unsigned long)to.writeMax, (unsigned long)to.eraseP99,
+        (unsigned long)to.eraseMax, (unsigned long)to.backlogMax, (unsigned long)to.writeErrors);
+    ESP_LOGI("Bench", "  push p99 %lu max %lu us  loop p99 %lu max %lu us",
+        (unsigned long)push.percentile(0.99f), (unsigned long)push.max(),
+        (unsigned long)loop.percentile(0.99f), (unsigned long)loop.max());
+}
+
+/**
+ * @brief 核心1上的忙循环，每个tick连续运行BURST_US，记录相邻迭代的间隔
+ *
+ * @note 循环本身在flash中，与采集和融合一样受cache关闭影响；
+ *       优先级低于生产者，被生产者抢占的间隔也会计入，通常只有几us
+ */
+void loopTask(void* pvParameters) {
+    (void) pvParameters;
+    while (true) {
+        if (!BENCH::looping.load(std::memory_order_acquire)) {
+            vTaskDelay(1);
+            continue;
+        }
+        int64_t start = esp_timer_get_time();
+        int64_t last = start;
+        int64_t now;
+        while ((now = esp_timer_get_time()) - start < BENCH::BURST_US) {
+            BENCH::loopGap.record((uint32_t)(now - last));
+            last = now;
+        }
+        vTaskDelay(1);
+    }
+}
+
+/**
+ * @brief 写入一段时间
+ *
+ * @param hz 记录频率，0为不限速，页缓冲满时让出CPU
+ * @param seconds 时长
+ */
+void run(const char* phase, uint32_t hz, int seconds) {
+    FlightLogStats before = flightLog.getStats();
+    LatencyHist push;
+    FlightRecord rec;
+    uint32_t pushed = 0;
+
+    BENCH::loopGap.reset();
+    BENCH::looping.store(true, std::memory_order_release);
+    int64_t t0 = esp_timer_get_time();
+    int64_t elapsed = 0;
+
+    while ((elapsed = esp_timer_get_time() - t0) < seconds * 1000000LL) {
+        if (hz) {
+            uint32_t due = elapsed * hz / 1000000; // 按时间应写入的条数，每个tick补齐
+            while (pushed < due) {
+                int64_t t = esp_timer_get_time();
+                rec.stamp = (uint32_t)t;
+                flightLog.push(rec);
+                push.record((uint32_t)(esp_timer_get_time() - t));
+                pushed++;
+            }
+            vTaskDelay(1);
+        }
+        else {
+            int64_t t = esp_timer_get_time();
+            rec.stamp = (uint32_t)t;
+            bool ok = flightLog.push(rec);
+            push.record((uint32_t)(esp_timer_get_time() - t));
+            if (!ok) vTaskDelay(1);
+        }
+    }
+
+    BENCH::looping.store(false, std::memory_order_release);
+    vTaskDelay(pdMS_TO_TICKS(200)); // 等写入任务写完已满的页，忙循环停下
+    report(phase, before, flightLog.getStats(), elapsed, push, BENCH::loopGap);
+}
+
+/* 创建RTOS任务函数 */
+void demo(void *pvParameters) {
+    (void) pvParameters; // 告诉编译器我知道这个没有别警告我
+
+    if (!flightLog.init() || !flightLog.startWriter(1, 0)) {
+        ESP_LOGE("FlightLog", "FlightLog Init Fail !");
+        vTaskDelete(NULL);
+        return;
+    }
+    ESP_LOGI("FlightLog", "FlightLog Init, %lu records !", (unsigned long)flightLog.capacity());
+    xTaskCreatePinnedToCore(loopTask, "loop", 2048, NULL, 4, NULL, 1);
+
+    run("200Hz", 200, 5);
+    run("1kHz", 1000, 5);
+    run("unlimited", 0, 5);
+    vTaskDelete(NULL);
+}
+
+extern "C" void app_main(void) {
+    xTaskCreatePinnedToCore(demo, "demo", 4096, NULL, 5, NULL, 1); // 生产者和忙循环在核心1，写入任务在核心0
+}
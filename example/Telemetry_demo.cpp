@@ -0,0 +1,86 @@
+#include "main.hpp"
+#include "telemetry.hpp"
+#include "esp_cpu.h"
+
+/*实例化化各外设*/
+UartConfig uartConfig = [] {
+    UartConfig config;
+    config.tx_buffer_size = 4096;
+    return config;
+}();
+Uart uart(UART_NUM_1, 17, 18, uartConfig); // 实例化串口
+COMM comm(uart); // 实例化通讯
+
+/* 测量一种编码下每个采样的平均编码耗时（CPU周期） */
+uint32_t measureEncode(uint8_t encoding) {
+    AttiBatcher batcher(encoding, 32);
+    Vec3lf atti;
+    uint32_t cycles = 0;
+    const int n = 3200;
+
+    for (int i = 0; i < n; i++) {
+        atti.x = 30.0 * sin(i * 0.002);
+        atti.y = 20.0 * cos(i * 0.003);
+        atti.z = 179.0 * sin(i * 0.0005);
+
+        uint32_t start = esp_cpu_get_cycle_count();
+        if (!batcher.push(i * 1000, atti)) {
+            batcher.reset();
+            batcher.push(i * 1000, atti);
+        }
+        cycles += esp_cpu_get_cycle_count() - start;
+    }
+    return cycles / n;
+}
+
+/* 创建RTOS任务函数 */ 
+void demo(void *pvParameters) {
+    (void) pvParameters; // 告诉编译器我知道这个没有别警告我
+
+    /* 初始化串口 */
+    if (uart.init()) {
+        ESP_LOGI("UART", "UART Init !");
+    }
+    else {
+        ESP_LOGE("UART", "UART Init Fail !");
+    }
+    comm.startTxTask(2);
+
+    /* 各编码的编码耗时 */
+    const char* name[4] = {"F32", "F16", "I16", "DELTA"};
+    for (uint8_t enc = ATTI_F32; enc <= ATTI_DELTA; enc++) {
+        ESP_LOGI("Encode", "%s: %lu cycles/sample", name[enc], (unsigned long)measureEncode(enc));
+    }
+
+    /* 以1kHz采样，每32个采样发送一帧差分编码的批量姿态 */
+    AttiBatcher batcher(ATTI_DELTA, 32);
+    const float hz = 1000;
+    Rate rate(hz);
+
+    int i = 0;
+    while (1)
+    {
+        Vec3lf atti;
+        atti.x = 30.0 * sin(i * 0.002);
+        atti.y = 20.0 * cos(i * 0.003);
+        atti.z = 179.0 * sin(i * 0.0005);
+        int64_t stamp = comm.hostTime(esp_timer_get_time()); // 上位机时钟，同步前为本机时钟
+        i++;
+
+        if (!batcher.push(stamp, atti)) {
+            comm.sendMsg(batcher.batch());
+            batcher.reset();
+            batcher.push(stamp, atti);
+        }
+        if (batcher.full()) {
+            comm.sendMsg(batcher.batch());
+            batcher.reset();
+        }
+
+        rate.sleep(); // 控制循环频率
+    }
+}
+
+extern "C" void app_main(void) {
+    xTaskCreate(demo, "demo", 4096, NULL, 1, NULL); // 创建RTOS任务
+}
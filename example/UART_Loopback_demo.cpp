@@ -0,0 +1,77 @@
+#include "main.hpp"
+
+/*实例化化各外设*/
+UartConfig uartConfig = [] {
+    UartConfig config;
+    config.rx_buffer_size = 8192;
+    config.tx_buffer_size = 8192;
+    return config;
+}();
+Uart uart(UART_NUM_1, 17, 18, uartConfig); // 实例化串口，内部回环时引脚不需要连线
+COMM comm(uart); // 实例化通讯
+
+/* 本链路上使用的消息 */
+using Msgs = MsgList<RoBoCmd, RoBoFeedBack>;
+
+/* 统计回环收到的反馈包 */
+struct CountHandler {
+    volatile uint32_t cnt = 0;
+
+    void onMsg(const RoBoCmd& msg) {
+        (void) msg;
+    }
+
+    void onMsg(const RoBoFeedBack& msg) {
+        (void) msg;
+        cnt = cnt + 1;
+    }
+} handler;
+
+/* 创建RTOS任务函数 */ 
+void demo(void *pvParameters) {
+    (void) pvParameters; // 告诉编译器我知道这个没有别警告我
+
+    /* 初始化串口 */
+    if (uart.init()) {
+        ESP_LOGI("UART", "UART Init !");
+    }
+    else {
+        ESP_LOGE("UART", "UART Init Fail !");
+    }
+
+    uart.setLoopBack(true);
+    uart.setRxThreshold(64, 4);
+    comm.startRxTask(handler, Msgs{}, 5);
+
+    const uint32_t bauds[] = {115200, 921600, 2000000, 3000000};
+    const int seconds = 2; // 每个波特率测试时长
+    RoBoFeedBack pack;
+
+    for (uint32_t baud : bauds) {
+        uart.waitTxDone(portMAX_DELAY);
+        uart.setBaud(baud);
+        delay_ms(10);
+
+        uint32_t sent = 0;
+        uint32_t start = handler.cnt;
+        int64_t t0 = esp_timer_get_time();
+        while (esp_timer_get_time() - t0 < seconds * 1000000LL) {
+            if (comm.uartSendPack(pack)) sent++; // 发送缓冲区满时阻塞，速率由线路决定
+        }
+        uart.waitTxDone(portMAX_DELAY);
+        delay_ms(10);
+
+        uint32_t rece = handler.cnt - start;
+        const size_t frameLen = PROTOCOL::OVERHEAD + sizeof(RoBoFeedBack);
+        ESP_LOGI("Loopback", "baud: %lu  sent: %lu  rece: %lu  %lu frame/s  %lu B/s",
+            (unsigned long)baud, (unsigned long)sent, (unsigned long)rece,
+            (unsigned long)(rece / seconds), (unsigned long)(rece * frameLen / seconds));
+    }
+
+    uart.setLoopBack(false);
+    vTaskDelete(NULL);
+}
+
+extern "C" void app_main(void) {
+    xTaskCreate(demo, "demo", 4096, NULL, 1, NULL); // 创建RTOS任务
+}
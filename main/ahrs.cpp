@@ -3,12 +3,103 @@
 AHRS::AHRS(const Vec3lf gyroBias_, const Vec3lf accelBias_, const Vec3lf accelGain_) :
     gyroBias(gyroBias_), 
     accelBias(accelBias_), 
-    accelGain(accelGain_) {
+    accelGain(accelGain_),
+    biasInit(gyroBias_.x != 0.0 || gyroBias_.y != 0.0 || gyroBias_.z != 0.0),
+    rejectSamples(0),
+    rejectWindows(0) {
+}
+
+namespace {
+    // 两个三轴向量每个轴都相差不超过tol
+    bool closeTo(const Vec3lf& a, const Vec3lf& b, double tol) {
+        return fabs(a.x - b.x) <= tol && fabs(a.y - b.y) <= tol && fabs(a.z - b.z) <= tol;
+    }
 }
 
 AHRS::~AHRS() {
 }
 
+/**
+ * @brief 获取当前陀螺仪零偏估计，可用于存入NVS
+ */
+Vec3lf AHRS::getGyroBias() const {
+    return gyroBias;
+}
+
+/**
+ * @brief 最近一次更新时是否处于静止
+ */
+bool AHRS::isStill() const {
+    return still.isStill();
+}
+
+/**
+ * @brief 更新静止检测，静止时用窗口内陀螺仪均值修正零偏
+ * 
+ * @param gyroData 陀螺仪数据（未去零偏）
+ * @param accelData 加速度计数据（已校准）
+ * 
+ * @note 匀速转动时方差同样很小，窗口均值需接近当前零偏（尚无估计时接近0）才被采用：
+ *       尚无零偏估计时直接采用首个合格窗口的均值，之后以一阶低通缓慢跟踪温漂。
+ *       出厂零偏过时或首次采用了转动中的均值时，所有静止窗口都会被拒绝，
+ *       连续REACQUIRE_WINDOWS个互相一致的被拒绝窗口后改用其均值
+ */
+void AHRS::_updateBias(const Vec3lf& gyroData, const Vec3lf& accelData) {
+    if (!still.update(gyroData, accelData)) {
+        rejectSamples = 0;
+        rejectWindows = 0;
+        return;
+    }
+
+    Vec3lf mean = still.gyroMean();
+
+    if (!biasInit) {
+        if (!closeTo(mean, Vec3lf{}, MAX_INIT_BIAS)) {
+            _rejectBias(mean);
+            return;
+        }
+        gyroBias = mean;
+        biasInit = true;
+        rejectSamples = 0;
+        rejectWindows = 0;
+        return;
+    }
+
+    if (!closeTo(mean, gyroBias, MAX_BIAS_STEP)) {
+        _rejectBias(mean);
+        return;
+    }
+    rejectSamples = 0;
+    rejectWindows = 0;
+
+    gyroBias.x += BIAS_GAIN * (mean.x - gyroBias.x);
+    gyroBias.y += BIAS_GAIN * (mean.y - gyroBias.y);
+    gyroBias.z += BIAS_GAIN * (mean.z - gyroBias.z);
+}
+
+/**
+ * @brief 累计被拒绝的静止窗口，每满一个窗口长度取一次均值，与第一个被拒绝窗口比较
+ *
+ * @param mean 当前窗口的陀螺仪均值
+ *
+ * @note 不一致时从当前窗口重新计数；连续一致的窗口足够多时认为这是新的零偏
+ */
+void AHRS::_rejectBias(const Vec3lf& mean) {
+    if (++rejectSamples < StillDetector::WINDOW) return; // 相邻两次取样的窗口不重叠
+    rejectSamples = 0;
+
+    if (!rejectWindows || !closeTo(mean, rejectMean, REACQUIRE_TOL)) {
+        rejectMean = mean;
+        rejectWindows = 1;
+        return;
+    }
+    if (++rejectWindows < REACQUIRE_WINDOWS) return;
+
+    gyroBias = mean;
+    biasInit = true;
+    rejectWindows = 0;
+}
+
 /**
  * @brief 互补滤波姿态角估计，由与欧拉角存在万象死锁的问题，因此会导致中间角趋近90度时另外两个角无法稳定计算。
  * 因此该算法不适于高速机动的结构。（右手系）
@@ -28,13 +119,16 @@ Vec3lf AHRS::attiEst(const Vec3lf& gyroData, const Vec3lf& accelData, float dt,
     /**
      * 对加速度计进行缩放和零偏校准，对陀螺仪进行零偏校准
      */
-    cailGyro.x =  (gyroData.x - gyroBias.x);
-    cailGyro.y =  (gyroData.y - gyroBias.y);
-    cailGyro.z =  (gyroData.z - gyroBias.z);
     cailAccel.x =  (accelData.x - accelBias.x) / accelGain.x;
     cailAccel.y =  (accelData.y - accelBias.y) / accelGain.y;
     cailAccel.z =  (accelData.z - accelBias.z) / accelGain.z;
 
+    _updateBias(gyroData, cailAccel); // 静止时修正零偏，本次采样即使用修正后的零偏
+
+    cailGyro.x =  (gyroData.x - gyroBias.x);
+    cailGyro.y =  (gyroData.y - gyroBias.y);
+    cailGyro.z =  (gyroData.z - gyroBias.z);
+
     /**
      * 加速度计可以在静止或匀速运动时解算出稳定的姿态角用于校准陀螺仪积分漂变，
      * 但其无法区分运动加速度，同时也无法解出Yaw所以须与陀螺仪和磁力计融合。
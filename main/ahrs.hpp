@@ -3,6 +3,7 @@
 
 #include <cmath>
 #include "struct.hpp"
+#include "still.hpp"
 
 // 可选的位姿估计算法
 namespace AHRS_MODE {
@@ -17,6 +18,8 @@ namespace AHRS_MODE {
  * @param gyroBias 陀螺仪零偏校准数据
  * @param accelBias 加速度计零偏校准数据
  * @param accelGain 加速度计缩放校准数据
+ *
+ * @note 内置静止检测，静止时在后台持续修正陀螺仪零偏，无需开机阻塞校准
  */
 class AHRS {
     public:
@@ -25,10 +28,27 @@ class AHRS {
 
         Vec3lf attiEst(const Vec3lf& gyroData, const Vec3lf& accelData, float dt, AHRS_MODE::CF); // 互补滤波
         Vec3lf attiEst(const Vec3lf& gyroData, const Vec3lf& accelData, const Vec3lf& meglData, float dt, AHRS_MODE::MahonyQ); // 互补滤波四元数
+
+        Vec3lf getGyroBias() const; // 当前陀螺仪零偏估计
+        bool isStill() const; // 当前是否静止
     private:
+        static constexpr double BIAS_GAIN = 0.001; // 静止时零偏的一阶低通系数
+        static constexpr double MAX_BIAS_STEP = 5.0; // 窗口均值偏离当前零偏超过该值时视为匀速转动而非静止（°/s）
+        static constexpr double MAX_INIT_BIAS = 10.0; // 尚无零偏估计时首个窗口均值的上限，超过视为转动（°/s）
+        static constexpr double REACQUIRE_TOL = 0.5; // 被拒绝的窗口之间均值相差不超过该值才算一致（°/s）
+        static constexpr uint32_t REACQUIRE_WINDOWS = 40; // 连续这么多个一致的被拒绝窗口后重新采用其均值，1kHz下约5s
+
         Vec3lf gyroBias, accelBias, accelGain; // 传感器校准数据
+        StillDetector still; // 静止检测器
+        bool biasInit; // 零偏是否已有有效估计
+        Vec3lf rejectMean; // 第一个被拒绝窗口的均值
+        uint32_t rejectSamples; // 当前被拒绝窗口已累计的静止采样数
+        uint32_t rejectWindows; // 连续一致的被拒绝窗口数
         Vec3lf lastAtti; // 姿态角数据（欧拉角）
         Quaternionlf lastAttiQ; // 姿态角数据（四元数）
+
+        void _updateBias(const Vec3lf& gyroData, const Vec3lf& accelData); // 静止检测及零偏修正
+        void _rejectBias(const Vec3lf& mean); // 累计被拒绝的静止窗口，必要时重新采用
 };
 
 #endif
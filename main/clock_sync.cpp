@@ -0,0 +1,100 @@
+#include "clock_sync.hpp"
+
+ClockSync::ClockSync() : m_num(0), m_pos(0), m_ref{0, 0, 0}, m_haveRef(false), m_drift(0.0f) {
+}
+
+ClockSync::~ClockSync() {
+}
+
+/**
+ * @brief 加入一组时钟同步时间戳
+ * 
+ * @param t1 本机发送ClockPing的时刻
+ * @param t2 上位机收到的时刻
+ * @param t3 上位机发送ClockPong的时刻
+ * @param t4 本机收到的时刻
+ */
+void ClockSync::addSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+    int64_t rtt = (t4 - t1) - (t3 - t2);
+    if (rtt < 0) return; // 时间戳错乱
+
+    Sample sample;
+    sample.local = t1 + (t4 - t1) / 2;
+    sample.offset = ((t2 - t1) + (t3 - t4)) / 2;
+    sample.rtt = rtt;
+
+    m_win[m_pos] = sample;
+    m_pos = (m_pos + 1) % WINDOW;
+    if (m_num < WINDOW) m_num++;
+
+    // 窗口内往返最小的样本
+    const Sample* best = &m_win[0];
+    for (int i = 1; i < m_num; i++) {
+        if (m_win[i].rtt < best->rtt) best = &m_win[i];
+    }
+
+    // 与上一个参考样本间隔足够长时更新漂移
+    if (!m_haveRef) {
+        m_ref = *best;
+        m_haveRef = true;
+    }
+    else if (best->local - m_ref.local >= MIN_DRIFT_SPAN) {
+        float slope = (float)(best->offset - m_ref.offset) / (float)(best->local - m_ref.local);
+        if (slope < MAX_DRIFT && slope > -MAX_DRIFT) {
+            m_drift += DRIFT_GAIN * (slope - m_drift);
+        }
+        m_ref = *best;
+    }
+
+    ClockState state;
+    state.refLocal = best->local;
+    state.offset = best->offset;
+    state.drift = m_drift;
+    state.rtt = best->rtt;
+    state.synced = true;
+    m_state.write(state);
+}
+
+/**
+ * @brief 本机时刻换算为上位机时刻，尚未同步（或恰好与参数发布重叠未读到）时原样返回
+ * 
+ * @param local 本机时刻（us），通常为esp_timer_get_time()
+ */
+int64_t ClockSync::toHost(int64_t local) const {
+    return toHost(getState(), local);
+}
+
+/**
+ * @brief 按getState取得的一份换算参数换算，时间戳与是否已同步需一致时使用
+ * 
+ * @param state 换算参数，synced为false时原样返回
+ * @param local 本机时刻（us）
+ */
+int64_t ClockSync::toHost(const ClockState& state, int64_t local) {
+    if (!state.synced) return local;
+
+    return local + state.offset + (int64_t)(state.drift * (float)(local - state.refLocal));
+}
+
+bool ClockSync::isSynced() const {
+    return m_state.version() != 0;
+}
+
+/**
+ * @brief 获取换算参数，读取与发布重叠未读到时返回默认值，其synced为false
+ */
+ClockState ClockSync::getState() const {
+    ClockState state;
+    m_state.read(state);
+    return state;
+}
+
+/**
+ * @brief 清空样本，链路重连或上位机重启后调用；已发布的换算参数保留到新样本到来
+ */
+void ClockSync::reset() {
+    m_num = 0;
+    m_pos = 0;
+    m_haveRef = false;
+    m_drift = 0.0f;
+}
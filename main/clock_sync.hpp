@@ -0,0 +1,57 @@
+#ifndef CLOCK_SYNC_HPP
+#define CLOCK_SYNC_HPP
+
+#include <cstdint>
+#include "mailbox.hpp"
+
+// 本机时钟到上位机时钟的换算参数
+struct ClockState
+{
+    int64_t refLocal = 0; // 参考点的本机时刻（us）
+    int64_t offset = 0; // 参考点处上位机时钟减本机时钟（us）
+    float drift = 0.0f; // 上位机时钟相对本机的速率差（s/s）
+    uint32_t rtt = 0; // 参考样本的往返时间（us）
+    bool synced = false; // 是否已有有效样本
+};
+
+/**
+ * @brief NTP方式的时钟同步估计器，估计上位机时钟相对本机的偏移和漂移
+ * 
+ * @note 最近WINDOW个样本中往返最小的一个排队延迟最少，作为偏移估计；
+ *       相邻两次估计的斜率经低通得到漂移，参考点之后的时刻按漂移外推。
+ *       样本在接收任务中加入，换算参数经顺序锁发布，任意任务可无锁调用toHost
+ */
+class ClockSync {
+    public:
+        ClockSync();
+        ~ClockSync();
+
+        void addSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4); // 加入一组时间戳
+        int64_t toHost(int64_t local) const; // 本机时刻换算为上位机时刻
+        static int64_t toHost(const ClockState& state, int64_t local); // 按给定的换算参数换算
+        bool isSynced() const;
+        ClockState getState() const;
+        void reset();
+    private:
+        static constexpr int WINDOW = 8; // 选取最小往返的样本窗口
+        static constexpr float DRIFT_GAIN = 0.2f; // 漂移低通系数
+        static constexpr float MAX_DRIFT = 500e-6f; // 晶振漂移上限，超出视为异常样本
+        static constexpr int64_t MIN_DRIFT_SPAN = 1000000; // 计算斜率的最短间隔（us），太短时噪声被放大
+
+        struct Sample {
+            int64_t local; // 样本中点的本机时刻
+            int64_t offset;
+            uint32_t rtt;
+        };
+        Sample m_win[WINDOW];
+        int m_num; // 窗口中的样本数
+        int m_pos; // 下一个样本的位置
+
+        Sample m_ref; // 上一次计算漂移使用的样本
+        bool m_haveRef;
+        float m_drift;
+
+        Mailbox<ClockState> m_state; // 发布的换算参数
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "cmd_mailbox.hpp"
+
+CmdMailbox::CmdMailbox(COMM& comm) : m_comm(comm), m_dropped(0) {
+}
+
+CmdMailbox::~CmdMailbox() {
+}
+
+/**
+ * @brief 接收任务回调，以本次接收事件的时刻作为到达时间戳
+ */
+void CmdMailbox::onMsg(const RoBoCmd& cmd) {
+    post(cmd, m_comm.getRxStamp());
+}
+
+/**
+ * @brief 投递一条指令，同时更新最新值和按序队列
+ * 
+ * @param cmd 指令
+ * @param stamp 到达时刻（us）
+ * 
+ * @note 只允许一个投递者（接收任务或轮询的任务）
+ */
+void CmdMailbox::post(const RoBoCmd& cmd, int64_t stamp) {
+    StampedCmd stamped;
+    stamped.cmd = cmd;
+    stamped.stamp = stamp;
+
+    m_latest.write(stamped);
+    if (!m_queue.push(stamped)) m_dropped++;
+}
+
+/**
+ * @brief 读取最新指令，不阻塞
+ * 
+ * @param out 最新指令及其到达时刻，可与当前时间比较判断是否过期
+ * 
+ * @return 版本号，每收到一条指令加一，与上次读取的版本号相同表示没有新指令；0表示尚未收到指令或与写入重叠未读到
+ */
+uint32_t CmdMailbox::latest(StampedCmd& out) const {
+    return m_latest.read(out);
+}
+
+/**
+ * @brief 最新指令的版本号，无需拷贝即可判断是否有新指令
+ */
+uint32_t CmdMailbox::version() const {
+    return m_latest.version();
+}
+
+/**
+ * @brief 按到达顺序取出一条指令
+ * 
+ * @return 队列空时返回false
+ */
+bool CmdMailbox::pop(StampedCmd& out) {
+    return m_queue.pop(out);
+}
+
+/**
+ * @brief 队列满丢弃的指令数，丢弃的指令仍会更新最新值
+ */
+uint32_t CmdMailbox::getQueueDropped() const {
+    return m_dropped;
+}
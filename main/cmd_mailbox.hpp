@@ -0,0 +1,45 @@
+#ifndef CMD_MAILBOX_HPP
+#define CMD_MAILBOX_HPP
+
+#include "datapack.hpp"
+#include "mailbox.hpp"
+#include "spsc_queue.hpp"
+
+// 带到达时间戳的指令
+struct StampedCmd
+{
+    RoBoCmd cmd;
+    int64_t stamp = 0; // 到达时刻（us），接收任务模式下为串口事件唤醒的时刻
+};
+
+/**
+ * @brief 指令邮箱，把COMM收到的指令无锁地交给控制循环
+ * 
+ * @param comm 用于获取指令到达时刻的通讯对象
+ * 
+ * @note 作为接收任务的处理者注册：comm.startRxTask(mailbox, MsgList<RoBoCmd>{}, prio)
+ *       latest：最新值，控制循环以常数时间读取，不阻塞，可由多个任务读取
+ *       pop：按序队列，供不允许丢失的消费者（如模式切换）使用，只允许一个消费者
+ */
+class CmdMailbox {
+    public:
+        CmdMailbox(COMM& comm);
+        ~CmdMailbox();
+
+        void onMsg(const RoBoCmd& cmd); // 接收任务回调
+        void post(const RoBoCmd& cmd, int64_t stamp); // 投递一条指令，轮询uartRecePack时手动调用
+
+        uint32_t latest(StampedCmd& out) const; // 读取最新指令
+        uint32_t version() const; // 最新指令的版本号
+        bool pop(StampedCmd& out); // 按序取出一条指令
+        uint32_t getQueueDropped() const; // 队列满丢弃的指令数
+    private:
+        static constexpr size_t QUEUE_SIZE = 16; // 按序队列长度
+
+        COMM& m_comm;
+        Mailbox<StampedCmd> m_latest; // 最新指令
+        SpscQueue<StampedCmd, QUEUE_SIZE> m_queue; // 按序队列
+        uint32_t m_dropped; // 队列满丢弃的指令数
+};
+
+#endif
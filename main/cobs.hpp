@@ -0,0 +1,59 @@
+#ifndef COBS_HPP
+#define COBS_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * COBS（Consistent Overhead Byte Stuffing）编码：把数据中的0x00全部替换为到下一个0x00的距离，
+ * 编码后的数据不含0x00，帧之间以0x00分隔。任何损坏都只影响到下一个0x00为止，接收端无需逐字节试探帧头。
+ * 两个函数都在原缓冲区上完成，不分配内存。
+ */
+namespace COBS {
+    constexpr size_t MAX_BLOCK = 254; // 单个码字节最多带的非零字节数
+
+    /**
+     * @brief 原地编码，数据不超过MAX_BLOCK - 1字节时只需一个起始码字节，无需移动数据
+     *
+     * @param buf buf[1..len]为待编码数据，buf[0]预留给起始码字节，buf[len + 1]写入分隔符
+     * @param len 数据长度，不超过MAX_BLOCK - 1
+     *
+     * @return 含分隔符的编码长度，即len + 2
+     */
+    inline size_t encode(uint8_t* buf, size_t len) {
+        size_t code = 0; // 当前码字节的位置
+        for (size_t i = 1; i <= len; i++) {
+            if (buf[i]) continue;
+            buf[code] = i - code; // 0x00替换为链表，由上一个码字节指向它
+            code = i;
+        }
+        buf[code] = len + 1 - code;
+        buf[len + 1] = 0x00;
+        return len + 2;
+    }
+
+    /**
+     * @brief 原地解码一帧（不含分隔符），输出总在输入之前，可以覆盖
+     *
+     * @param buf 编码数据，解码结果从buf[0]开始写入
+     * @param len 编码长度
+     * @param outLen 解码长度
+     *
+     * @return 编码合法返回true；码字节为0或越过帧尾时返回false
+     */
+    inline bool decode(uint8_t* buf, size_t len, size_t& outLen) {
+        size_t in = 0;
+        size_t out = 0;
+        while (in < len) {
+            uint8_t code = buf[in++];
+            if (!code || in + code - 1 > len) return false;
+
+            for (uint8_t k = 1; k < code; k++) buf[out++] = buf[in++];
+            if (code != MAX_BLOCK + 1 && in < len) buf[out++] = 0x00; // 满块后没有被替换的0x00
+        }
+        outLen = out;
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,74 @@
+#include "datapack.hpp"
+#include "freertos/task.h"
+#include <cstdio>
+
+/**
+ * linux目标上的COMM压测程序
+ * 以伪终端代替串口，把收到的每条指令原样装进反馈回传，由上位机 tools/comm_peer.py 产生流量并校验回传
+ * 
+ * 编译：idf.py --preview set-target linux && idf.py build
+ * 运行：./build/ESP32Test.elf，再按提示启动 comm_peer.py
+ */
+PtyTransport pty; // 伪终端传输层
+COMM comm(pty); // 实例化通讯
+
+/* 本链路上使用的消息 */
+using Msgs = MsgList<RoBoCmd, RoBoFeedBack>;
+
+/* 回传处理者，在接收任务中被调用 */
+struct EchoHandler {
+    uint32_t cnt = 0; // 收到的指令数
+
+    void onMsg(const RoBoCmd& cmd) {
+        RoBoFeedBack fb;
+        fb.roll = cmd.val1;
+        fb.pitch = cmd.val2;
+        fb.yaw = cmd.val3;
+        fb.reserved1 = cmd.val4;
+        fb.status = cmd.mode1;
+        fb.reserved2 = cmd.mode2;
+        comm.uartSendPack(fb); // 带上位机时钟的时间戳
+        cnt++;
+    }
+
+    void onMsg(const RoBoFeedBack& msg) {
+        (void) msg;
+    }
+} handler;
+
+extern "C" void app_main(void) {
+    if (!pty.init()) {
+        printf("PTY Init Fail !\n");
+        return;
+    }
+    printf("PTY ready, run: python3 tools/comm_peer.py %s\n", pty.getPath());
+
+    comm.setMaxBaud(3000000); // 允许上位机测试波特率协商
+    comm.startTxTask(2, tskNO_AFFINITY, TX_DROP); // 压测需要统计真实的丢帧
+    comm.startRxTask(handler, Msgs{}, 5);
+
+    uint32_t lastCnt = 0;
+    int cnt = 0;
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+
+        /* 100Hz心跳反馈，没有指令时也能把确认带回上位机，roll为-1以区别于回传 */
+        RoBoFeedBack heartbeat;
+        heartbeat.roll = -1.0f;
+        comm.uartSendPack(heartbeat);
+
+        if (++cnt < 100) continue;
+        cnt = 0;
+
+        TxStats tx = comm.getTxStats();
+        LatencyReport report = comm.getLatencyReport();
+        comm.sendMsg(report); // 上位机汇总各阶段延迟
+        printf("rx %lu/s  tx frames %lu dropped %lu  rx p99 %lu  proc p99 %lu  tx p99 %lu us  rtt %lu us  offset %lld us  drift %.1f ppm\n",
+            (unsigned long)(handler.cnt - lastCnt), (unsigned long)tx.frames, (unsigned long)tx.dropped,
+            (unsigned long)report.rx.p99, (unsigned long)report.proc.p99, (unsigned long)report.tx.p99,
+            (unsigned long)report.rtt, (long long)report.offset, report.drift);
+        printf("crc errors %lu  duplicate %lu  stale %lu\n", (unsigned long)comm.getRxCrcErrors(),
+            (unsigned long)comm.getRxDuplicate(), (unsigned long)comm.getRxStale());
+        lastCnt = handler.cnt;
+    }
+}
@@ -0,0 +1,69 @@
+#include "crc16.hpp"
+#include "esp_attr.h"
+
+namespace {
+    struct CRC16Table {
+        uint16_t t[CRC16_SLICE][256];
+    };
+
+    // 编译期生成查表，t[k][i]为字节i后再跟k个零字节的CRC贡献
+    constexpr CRC16Table makeTable() {
+        CRC16Table table = {};
+        for (int i = 0; i < 256; i++) {
+            uint16_t crc = i;
+            for (int b = 0; b < 8; b++)
+                crc = (crc & 1) ? (crc >> 1) ^ CRC16::POLY : crc >> 1;
+            table.t[0][i] = crc;
+        }
+        for (int k = 1; k < CRC16_SLICE; k++)
+            for (int i = 0; i < 256; i++)
+                table.t[k][i] = (table.t[k - 1][i] >> 8) ^ table.t[0][table.t[k - 1][i] & 0xFF];
+        return table;
+    }
+
+    DRAM_ATTR const CRC16Table crcTable = makeTable(); // 放在DRAM中，避免flash cache未命中
+}
+
+/**
+ * @brief 在已有CRC的基础上继续计算，用于数据分段到达的场合
+ * 
+ * @param crc 之前的计算结果，首次传入CRC16::INIT
+ * @param bytesBuf 本段数据
+ * @param len 本段长度
+ * 
+ * @return 更新后的CRC
+ */
+uint16_t CRC16::update(uint16_t crc, const void* bytesBuf, size_t len) {
+    const uint8_t* data = static_cast<const uint8_t*>(bytesBuf);
+    const auto& t = crcTable.t;
+
+#if CRC16_SLICE == 8
+    while (len >= 8) {
+        crc ^= data[0] | (data[1] << 8);
+        crc = t[7][crc & 0xFF] ^ t[6][crc >> 8] ^ t[5][data[2]] ^ t[4][data[3]] ^
+              t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+        data += 8;
+        len -= 8;
+    }
+#elif CRC16_SLICE == 4
+    while (len >= 4) {
+        crc ^= data[0] | (data[1] << 8);
+        crc = t[3][crc & 0xFF] ^ t[2][crc >> 8] ^ t[1][data[2]] ^ t[0][data[3]];
+        data += 4;
+        len -= 4;
+    }
+#endif
+
+    // 剩余字节逐个处理
+    while (len--) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+/**
+ * @brief 计算一段数据的CRC-16/MODBUS
+ */
+uint16_t CRC16::calc(const void* bytesBuf, size_t len) {
+    return update(INIT, bytesBuf, len);
+}
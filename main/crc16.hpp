@@ -0,0 +1,36 @@
+#ifndef CRC16_HPP
+#define CRC16_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * 查表方式，编译期选择：
+ * 1 - 单字节查表（512B表）
+ * 4 - slice-by-4（2KB表）
+ * 8 - slice-by-8（4KB表）
+ * 
+ * ESP ROM中的esp_rom_crc16_le是CRC-16/CCITT多项式，与MODBUS不符，因此不使用ROM实现
+ */
+#ifndef CRC16_SLICE
+#define CRC16_SLICE 8
+#endif
+
+static_assert(CRC16_SLICE == 1 || CRC16_SLICE == 4 || CRC16_SLICE == 8, "CRC16_SLICE must be 1, 4 or 8");
+
+/**
+ * @brief CRC-16/MODBUS计算，支持分段增量计算
+ * 
+ * @note 用法：crc = CRC16::INIT; crc = CRC16::update(crc, a, lenA); crc = CRC16::update(crc, b, lenB);
+ *       结果与一次性计算整段数据相同
+ */
+class CRC16 {
+    public:
+        static constexpr uint16_t INIT = 0xFFFF; // 初始值
+        static constexpr uint16_t POLY = 0xA001; // 反射多项式0x8005
+
+        static uint16_t update(uint16_t crc, const void* bytesBuf, size_t len); // 在已有crc基础上继续计算
+        static uint16_t calc(const void* bytesBuf, size_t len); // 计算整段数据
+};
+
+#endif
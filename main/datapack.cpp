@@ -1,162 +1,702 @@
 #include "datapack.hpp"
 
-COMM::COMM(Uart& uartClass) :
-    m_uart(uartClass), packStatus(WAITING_FOR_HEADER_1), rx_cnt(0) {
+COMM::COMM(Transport& transport) :
+    m_uart(transport), m_rx_task(NULL), m_rx_handler(nullptr), m_rx_thunk(nullptr),
+    m_rx_wake(0), m_rx_stamp(0), m_rx_overflow(0), m_rx_crc_err(0), m_rx_dup(0), m_rx_stale(0), m_ack_seq(0), m_ack_bits(0),
+    m_tx_fill(0), m_tx_policy(TX_COALESCE), m_tx_task(NULL), m_tx_lock(portMUX_INITIALIZER_UNLOCKED),
+    m_max_baud(0), m_baud_prev(0), m_baud_pending(0), m_baud_deadline(0), m_baud_fallback(0),
+    m_sync_period(1000000), m_sync_next(0), m_sync_backoff(0), m_ping_seq(0), m_rx_mark(0), m_rx_total(0) {
 }
 
 COMM::~COMM() {
 }
 
-// CRC校验表
-const uint16_t COMM::crc16Table[256] = {
-    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241, 
-    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440, 
-    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40, 
-    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841, 
-    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40, 
-    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41, 
-    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641, 
-    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040, 
-    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240, 
-    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441, 
-    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41, 
-    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840, 
-    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41, 
-    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40, 
-    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640, 
-    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041, 
-    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240, 
-    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441, 
-    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41, 
-    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840, 
-    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41, 
-    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40, 
-    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640, 
-    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041, 
-    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241, 
-    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440, 
-    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40, 
-    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841, 
-    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40, 
-    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41, 
-    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641, 
-    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
-};
+/**
+ * @brief 以串口发送反馈数据包
+ * 
+ * @param pack 要发送的数据包，帧头和校验和在编码时自动生成，stamp、synced和确认状态在此填入
+ * 
+ * @note 只应在一个任务中调用，m_ack_sent由该任务独占
+ */
+bool COMM::uartSendPack(const RoBoFeedBack& pack) {
+    RoBoFeedBack stamped = pack;
+    ClockState clock = m_clock.getState(); // 时间戳和synced取自同一份参数，读取失败时按未同步发出本机时刻
+    stamped.stamp = ClockSync::toHost(clock, esp_timer_get_time());
+    stamped.synced = clock.synced;
+
+    m_ack.read(m_ack_sent); // 与发布重叠未读到时沿用上次发出的确认状态，不能发出表示重置的ackSeq 0
+    stamped.ackSeq = m_ack_sent.seq;
+    stamped.ackBits = m_ack_sent.bits;
+    return sendMsg(stamped);
+}
+
+/**
+ * @brief 把串口中所有可用数据非阻塞地读入接收环形缓冲区，环尾处分两段读取
+ * 
+ * @return 环形缓冲区被填满，串口中可能还有未读数据时返回true
+ */
+bool COMM::_fillRing() {
+    for (int i = 0; i < 2; i++) {
+        uint8_t* ptr;
+        size_t space = m_rx_ring.writeSpan(ptr);
+        if (!space) return true;
+
+        int len = m_uart.read(ptr, space, 0); // 非阻塞读取
+        if (len <= 0) return false;
+        m_rx_ring.commit(len);
+
+        // 事件唤醒后第一次读到的数据在唤醒前已到达，之后读到的按读取时刻
+        m_rx_total += len;
+        m_rx_mark = (m_rx_mark + 1) % RX_MARKS;
+        m_rx_marks[m_rx_mark].end = m_rx_total;
+        m_rx_marks[m_rx_mark].stamp = m_rx_wake ? m_rx_wake : esp_timer_get_time();
+        m_rx_wake = 0;
+        if ((size_t)len < space) return false; // 串口已读空
+    }
+    return m_rx_ring.space() == 0;
+}
 
 /**
- * @brief 生成16位CRC校验和，CRC-16/MODBUS 标准
+ * @brief 从接收缓冲区中取出下一个通过校验的帧
  * 
- * @param bytesBuf 需要生成校验的实际发送的字节流
- * @param len 除校验和以外长度
+ * @param id 帧的消息ID
+ * @param payload 指向帧负载，在下一次调用前有效
+ * @param len 负载长度
  * 
- * @return 校验和
+ * @return 取到完整的帧返回true，数据不足时返回false，不完整的帧保留在缓冲区中
  */
-uint16_t COMM::_createCRC16(const void* bytesBuf, size_t len) const {
-    uint16_t crc = 0xFFFF;
-    const uint8_t* data = static_cast<const uint8_t*>(bytesBuf);
+bool COMM::_nextFrame(uint8_t& id, const uint8_t*& payload, size_t& len) {
+    RxParse& p = m_rx_parse;
+#if COMM_FRAMING == COMM_FRAMING_COBS
+    uint8_t* body = m_rx_frame + 2; // 编码数据放在帧体的位置原地解码，前面补上0x55 0xAA即与帧头格式的帧相同
+    while (true) {
+        // 分隔符之间即一帧，损坏只影响本帧，不需要逐字节试探；已处理的字节中没有分隔符，只在新到的字节中找
+        size_t size = m_rx_ring.size();
+        size_t end = m_rx_ring.find(0x00, p.in);
+        if (end > PROTOCOL::MAX_FRAME) {
+            p = RxParse();
+            if (end == size) { // 超长仍无分隔符，必为噪声
+                m_rx_ring.drop(end);
+                return false;
+            }
+            m_rx_ring.drop(end + 1);
+            m_rx_crc_err++;
+            continue;
+        }
+
+        // 新到的编码字节逐个解码，解码结果总在输入之前，可以原地覆盖
+        if (end > p.in) {
+            m_rx_ring.copyOut(p.in, body + p.in, end - p.in);
+            for (size_t i = p.in; i < end; i++) {
+                uint8_t code = body[i];
+                if (p.left) {
+                    body[p.out++] = code;
+                    p.left--;
+                    continue;
+                }
+                if (p.zero) body[p.out++] = 0x00; // 上一块之后被替换掉的0x00，确认不是帧尾时才补上
+                p.left = code - 1;
+                p.zero = code != COBS::MAX_BLOCK + 1;
+            }
+            p.in = end;
+
+            // CRC比解码落后两个字节，帧结束时正好不含末尾的校验和
+            m_rx_frame[0] = HEADER_1;
+            m_rx_frame[1] = HEADER_2;
+            p.crc = CRC16::update(p.crc, m_rx_frame + p.crcLen, p.out - p.crcLen);
+            p.crcLen = p.out;
+        }
+        if (end == size) return false; // 帧不完整，等待后续数据
+
+        RxParse done = p;
+        p = RxParse();
+        m_rx_ring.drop(end + 1);
+        if (!end) continue; // 空帧
+
+        if (done.left || done.out < 4 || done.out != 4 + (size_t)body[1]) { // 最后一块越过帧尾或长度不符
+            m_rx_crc_err++;
+            continue;
+        }
+
+        size_t payloadLen = body[1];
+        size_t frameLen = PROTOCOL::OVERHEAD + payloadLen;
+        uint16_t received = m_rx_frame[frameLen - 2] | (m_rx_frame[frameLen - 1] << 8);
+        if (done.crc != received) {
+            m_rx_crc_err++;
+            continue;
+        }
+
+        id = m_rx_frame[2];
+        payload = m_rx_frame + PROTOCOL::HEAD_LEN;
+        len = payloadLen;
+        return true;
+    }
+#else
+    while (true) {
+        if (!p.in) {
+            // 用memchr批量跳过非帧头字节
+            m_rx_ring.drop(m_rx_ring.find(HEADER_1));
+            if (m_rx_ring.size() < PROTOCOL::HEAD_LEN) return false;
+
+            if (m_rx_ring.peek(1) != HEADER_2) { // 假帧头
+                m_rx_ring.drop(1);
+                continue;
+            }
+        }
+
+        size_t payloadLen = m_rx_ring.peek(3);
+        size_t crcLen = PROTOCOL::HEAD_LEN + payloadLen; // CRC包含帧头
+        size_t frameLen = crcLen + PROTOCOL::CRC_LEN;
+
+        // 新到的帧字节批量拷进帧缓冲并计入CRC，上次已计入的不再重复
+        size_t avail = m_rx_ring.size() < crcLen ? m_rx_ring.size() : crcLen;
+        if (avail > p.in) {
+            m_rx_ring.copyOut(p.in, m_rx_frame + p.in, avail - p.in);
+            p.crc = CRC16::update(p.crc, m_rx_frame + p.in, avail - p.in);
+            p.in = avail;
+        }
+        if (m_rx_ring.size() < frameLen) return false; // 帧不完整，等待后续数据
+
+        m_rx_ring.copyOut(crcLen, m_rx_frame + crcLen, PROTOCOL::CRC_LEN);
+        uint16_t received = m_rx_frame[crcLen] | (m_rx_frame[crcLen + 1] << 8);
+        uint16_t crc = p.crc;
+        p = RxParse();
+        if (crc != received) {
+            // 校验失败可能是负载中的假帧头，只跳过当前帧头字节，在剩余数据中继续寻找
+            m_rx_crc_err++;
+            m_rx_ring.drop(1);
+            continue;
+        }
 
-    for (size_t i = 0; i < len; ++i) {
-        uint8_t index = (crc ^ data[i]) & 0xFF;
-        crc = (crc >> 8) ^ crc16Table[index];
+        m_rx_ring.drop(frameLen);
+        id = m_rx_frame[2];
+        payload = m_rx_frame + PROTOCOL::HEAD_LEN;
+        len = payloadLen;
+        return true;
     }
-    return crc;
+#endif
 }
 
 /**
- * @brief 以串口发送数据包
+ * @brief 清空接收缓冲区，丢弃解析到一半的帧
+ */
+void COMM::_clearRx() {
+    m_rx_ring.clear();
+    m_rx_parse = RxParse();
+}
+
+/**
+ * @brief 从串口收取一次数据，并解出其中所有完整的指令包，其他消息被丢弃
  * 
- * @param pack 要发送的数据包，传入时无需自己添加检验和，函数内自动生成
+ * @param packBuf 解包成功数据包的缓存区数组
+ * @param maxNum 缓存区最多能存放的包数
+ * 
+ * @return 解出的包数，超出maxNum的包和不完整的包保留在接收缓冲区中，下次调用继续解出
  */
-bool COMM::uartSendPack(RoBoFeedBack& pack) {
-    size_t len = sizeof(pack); // 检查包长度
-    uint16_t crc = _createCRC16(&pack, len - 2); // 生成CRC16，长度减2是因为最后两个字节是16位CRC校验和
-    pack.checksum = crc; // 传入校验和
-    return m_uart.write(&pack, len); // 发送
+size_t COMM::uartRecePack(RoBoCmd* packBuf, size_t maxNum) {
+    size_t num = 0;
+    uint8_t id;
+    const uint8_t* payload;
+    size_t len;
+
+    _fillRing();
+
+    while (num < maxNum && _nextFrame(id, payload, len)) {
+        m_rx_stamp = _frameStamp();
+        if (_linkMsg(id, payload, len)) continue;
+        if (id == RoBoCmd::ID) {
+            uint16_t seq = PROTOCOL::readSeq(payload, len, PROTOCOL::seqOffset<RoBoCmd>());
+            if (seq && !_acceptSeq(seq)) continue; // 上位机重发的可靠指令，已处理过
+            PROTOCOL::decode(payload, len, packBuf[num]);
+            num++;
+        }
+    }
+
+    linkTick();
+    return num;
 }
 
 /**
- * @brief 从串口收取一次数据，并尝试解包数据包，单次未解出完整的数据包会暂存进传入对象的缓冲区
+ * @brief 从串口收取一次数据，并尝试解出一个指令包，其余数据保留在接收缓冲区中
  * 
  * @param packBuf 解包成功数据包的缓存区
  * 
  * @return 成功解出完整的包返回true，此时只要读取传入的缓冲区即可
  */
 bool COMM::uartRecePack(RoBoCmd& packBuf) {
-    // 1. 从串口读取所有可用的数据到临时缓冲区
-    // 注意：这里要用 m_rx_temp_buf，而不是旧的 bytesBuf
-    int len = m_uart.read(m_rx_temp_buf, sizeof(m_rx_temp_buf), 0); // 非阻塞读取
-
-    if (len <= 0) {
-        return false; // 没有新数据，直接返回
-    }
-    
-    // 2. 逐字节将新数据送入状态机处理
-    for (int i = 0; i < len; ++i) {
-        uint8_t byte = m_rx_temp_buf[i];
-
-        switch (packStatus) {
-            case WAITING_FOR_HEADER_1:
-                if (byte == 0x55) {
-                    // 找到了第一个帧头，将其存入组包缓冲区的起始位置
-                    m_rx_packet_buf[0] = byte;
-                    rx_cnt = 1; // 已经收到了1个字节
-                    packStatus = WAITING_FOR_HEADER_2;
-                }
+    return uartRecePack(&packBuf, 1) == 1;
+}
+
+/**
+ * @brief 刚由_nextFrame取出的帧的到达时刻，即读入其最后一个字节的那次读取的时刻
+ * 
+ * @note 帧比记录的读取都早时（uartRecePack留下的帧）取最早一次读取的时刻，偏晚
+ */
+int64_t COMM::_frameStamp() const {
+    uint32_t end = m_rx_total - m_rx_ring.size(); // 帧最后一个字节之后的累计位置
+    int64_t stamp = m_rx_marks[m_rx_mark].stamp;
+    for (size_t i = 1; i < RX_MARKS; i++) { // 从新往旧，找到最早已读入该字节的一次
+        const RxMark& mark = m_rx_marks[(m_rx_mark + RX_MARKS - i) % RX_MARKS];
+        if (!mark.stamp || (int32_t)(mark.end - end) < 0) break;
+        stamp = mark.stamp;
+    }
+    return stamp;
+}
+
+/**
+ * @brief 记录从帧到达到当前消息分发的延迟，由receMsgs在返回前发布给其他任务
+ * 
+ * @param now 分发的时刻
+ */
+void COMM::_recordLatency(int64_t now) {
+    uint32_t lat = now - m_rx_stamp;
+    m_hist_rx.record(lat);
+    m_rx_lat.last = lat;
+    if (lat > m_rx_lat.max) m_rx_lat.max = lat;
+    m_rx_lat.sum += lat;
+    m_rx_lat.cnt++;
+}
+
+/**
+ * @brief 接收任务，阻塞等待串口事件，有数据即解包，溢出时清空缓冲区重新同步
+ */
+void COMM::_rxTask(void* arg) {
+    COMM& comm = *static_cast<COMM*>(arg);
+
+    while (true) {
+        // 定时醒来检查波特率协商超时
+        RX_EVENT event = comm.m_uart.waitRxEvent(LINK_TICK);
+        comm.linkTick();
+
+        switch (event) {
+            case RX_DATA:
+                comm.m_rx_wake = esp_timer_get_time();
+                comm.m_rx_thunk(comm, comm.m_rx_handler);
                 break;
 
-            case WAITING_FOR_HEADER_2:
-                if (byte == 0xAA) {
-                    // 找到了第二个帧头，存入组包缓冲区
-                    m_rx_packet_buf[1] = byte;
-                    rx_cnt = 2; // 已经收到了2个字节
-                    packStatus = RECEIVING_DATA;
-                } else {
-                    // 序列错误，重置状态机
-                    // 如果当前字节恰好是新的帧头1，则可以直接进入 HEADER_2 状态
-                    if (byte == 0x55) {
-                        m_rx_packet_buf[0] = byte;
-                        rx_cnt = 1;
-                        // 状态保持 WAITING_FOR_HEADER_2
-                    } else {
-                        packStatus = WAITING_FOR_HEADER_1;
-                    }
-                }
+            case RX_OVERFLOW:
+                // 数据已丢失，丢弃残帧从头同步
+                comm.m_uart.flushInput();
+                comm._clearRx();
+                comm.m_rx_overflow++;
                 break;
 
-            case RECEIVING_DATA:
-                // 将数据负载和校验和存入组包缓冲区
-                m_rx_packet_buf[rx_cnt++] = byte;
-
-                // 3. 检查是否已收到一个完整的数据包
-                if (rx_cnt == sizeof(RoBoCmd)) { // RoBoCmd 总长为22字节
-                    // 定义数据包长度常量，提高可读性
-                    constexpr size_t full_packet_len = sizeof(RoBoCmd); // 22
-                    constexpr size_t checksum_data_len = full_packet_len - 2; // 20
-
-                    // 4. 执行CRC校验 (根据你的要求，CRC包含帧头)
-                    // 计算范围是 m_rx_packet_buf 中的前20个字节
-                    uint16_t calculated_crc = _createCRC16(m_rx_packet_buf, checksum_data_len);
-
-                    // 从接收到的数据中提取校验和 (最后两个字节)
-                    uint16_t received_checksum = *reinterpret_cast<uint16_t*>(&m_rx_packet_buf[checksum_data_len]);
-                    
-                    // 无论校验成功与否，都重置状态机，准备接收下一个包
-                    packStatus = WAITING_FOR_HEADER_1;
-                    rx_cnt = 0;
-
-                    // ESP_LOGI("RxPack", "%X  %X", calculated_crc, received_checksum);
-                    if (calculated_crc == received_checksum) {
-                        // 校验成功！将组包缓冲区的内容完整地拷贝到输出参数
-                        memcpy(&packBuf, m_rx_packet_buf, full_packet_len);
-                        return true; // 成功解析一个包
-                    }
-                    // 如果校验失败，不做任何事，函数将会在 for 循环结束后返回 false
-                    // 状态机已经重置，可以继续在当前批次剩余的字节中寻找新包头
-                }
+            default:
                 break;
-        } // end switch
-    } // end for
+        }
+    }
+}
+
+/**
+ * @brief 当前正在分发的消息的到达时刻（us），供处理者给消息打时间戳
+ * 
+ * @note 取读入帧最后一个字节的那次读取的时刻；接收任务中串口事件后的第一次读取取事件唤醒的时刻，
+ *       串口驱动不记录字节到达的时刻，唤醒之前在事件队列中等待的时间无法计入
+ */
+int64_t COMM::getRxStamp() const {
+    return m_rx_stamp;
+}
+
+/**
+ * @brief 获取接收延迟统计，可在任意任务中调用
+ */
+RxLatency COMM::getRxLatency() const {
+    RxLatency lat;
+    m_rx_lat_pub.read(lat);
+    return lat;
+}
+
+/**
+ * @brief 获取接收溢出次数
+ */
+uint32_t COMM::getRxOverflow() const {
+    return m_rx_overflow;
+}
+
+/**
+ * @brief 获取校验失败次数，包括损坏的帧和负载中恰好出现的假帧头
+ */
+uint32_t COMM::getRxCrcErrors() const {
+    return m_rx_crc_err;
+}
+
+/**
+ * @brief 获取被去重的可靠消息数，即上位机重发但此前已收到的消息
+ */
+uint32_t COMM::getRxDuplicate() const {
+    return m_rx_dup;
+}
+
+/**
+ * @brief 获取因落后太多被丢弃的可靠消息数，持续增长说明上位机重启后没有发送SeqReset
+ */
+uint32_t COMM::getRxStale() const {
+    return m_rx_stale;
+}
+
+/**
+ * @brief 获取可靠通道的确认状态，uartSendPack已自动带上，其他遥测帧可自行附带
+ */
+AckState COMM::getAckState() const {
+    AckState ack;
+    m_ack.read(ack);
+    return ack;
+}
+
+/**
+ * @brief 登记一个可靠序号并更新确认位图
+ * 
+ * @param seq 可靠序号，非0
+ * 
+ * @return 首次收到返回true；已收到过或已过期返回false，消息应丢弃
+ * 
+ * @note 串口不会乱序，领先超过位图范围的序号是中间的消息都已放弃，以其为新起点；
+ *       落后超过位图范围的序号是过期的重发，丢弃。上位机重启须先发送SeqReset，见_linkMsg
+ */
+bool COMM::_acceptSeq(uint16_t seq) {
+    int16_t diff = (int16_t)(uint16_t)(seq - m_ack_seq);
+
+    if (!m_ack_seq || diff > 32) { // 首个序号或跳过了整个位图
+        m_ack_bits = 0;
+        m_ack_seq = seq;
+    }
+    else if (diff < -32) { // 过期的重发
+        m_rx_stale++;
+        return false;
+    }
+    else if (diff > 0) { // 新的最新序号，旧的最新序号移入位图
+        m_ack_bits = (diff == 32 ? 0 : m_ack_bits << diff) | (1u << (diff - 1));
+        m_ack_seq = seq;
+    }
+    else if (diff == 0) {
+        m_rx_dup++;
+        return false;
+    }
+    else { // 较早的序号，重发后补上的
+        uint32_t bit = 1u << (-diff - 1);
+        if (m_ack_bits & bit) {
+            m_rx_dup++;
+            return false;
+        }
+        m_ack_bits |= bit;
+    }
+
+    AckState ack;
+    ack.seq = m_ack_seq;
+    ack.bits = m_ack_bits;
+    m_ack.write(ack);
+    return true;
+}
+
+/**
+ * @brief 设置允许上位机协商的最高波特率，默认为0即不接受任何切换请求
+ */
+void COMM::setMaxBaud(uint32_t baud) {
+    m_max_baud = baud;
+}
+
+/**
+ * @brief 处理链路控制消息
+ * 
+ * @return 是链路控制消息返回true，不再分发给处理者
+ */
+bool COMM::_linkMsg(uint8_t id, const uint8_t* payload, size_t len) {
+    switch (id) {
+        case BaudReq::ID: {
+            BaudReq req;
+            PROTOCOL::decode(payload, len, req);
+
+            BaudAck ack;
+            ack.baud = req.baud;
+            ack.accept = !m_baud_pending && req.baud >= BAUD_MIN && req.baud <= m_max_baud;
+            _sendNow(ack); // 必须在切换前以旧波特率发出，不经过发送队列
+
+            if (ack.accept) {
+                // 应答以旧波特率发完后再切换
+                m_uart.waitTxDone(pdMS_TO_TICKS(50));
+                m_baud_prev = m_uart.getBaud();
+                if (m_uart.setBaud(req.baud)) {
+                    m_baud_pending = req.baud;
+                    m_baud_deadline = esp_timer_get_time() + BAUD_CONFIRM_TIMEOUT;
+                    _clearRx(); // 切换前后的残余字节无法解析
+                }
+            }
+            return true;
+        }
+
+        case BaudConfirm::ID: {
+            BaudConfirm confirm;
+            PROTOCOL::decode(payload, len, confirm);
+
+            if (m_baud_pending && confirm.baud == m_baud_pending) {
+                m_baud_pending = 0; // 协商完成
+                _sendNow(confirm); // 回显，告知上位机新波特率已生效
+            }
+            return true;
+        }
+
+        case BaudAck::ID:
+            return true;
 
-    // 遍历完所有新数据，但尚未形成一个完整的包
-    return false;
+        case ClockPing::ID: {
+            ClockPing ping;
+            PROTOCOL::decode(payload, len, ping);
+
+            ClockPong pong;
+            pong.seq = ping.seq;
+            pong.t1 = ping.t1;
+            pong.t2 = getRxStamp();
+            pong.t3 = esp_timer_get_time();
+            _sendNow(pong); // 不经过发送队列，t3尽量接近实际发出的时刻
+            return true;
+        }
+
+        case ClockPong::ID: {
+            ClockPong pong;
+            PROTOCOL::decode(payload, len, pong);
+
+            if (pong.seq == m_ping_seq) m_clock.addSample(pong.t1, pong.t2, pong.t3, getRxStamp()); // 过期的应答丢弃
+            return true;
+        }
+
+        case SeqReset::ID:
+            // 上位机重启，之后的序号重新开始；确认状态清零，上位机看到ackSeq为0后才发送可靠消息
+            m_ack_seq = 0;
+            m_ack_bits = 0;
+            m_ack.write(AckState());
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief 检查波特率协商是否超时，超时未收到确认则退回原波特率
+ */
+void COMM::linkTick() {
+    _syncTick();
+
+    if (!m_baud_pending) return;
+    if (esp_timer_get_time() < m_baud_deadline) return;
+
+    m_uart.setBaud(m_baud_prev);
+    _clearRx();
+    m_baud_pending = 0;
+    m_baud_fallback++;
+}
+
+/**
+ * @brief 到期时向上位机发送ClockPing，启动阶段加快发送以尽快填满样本窗口
+ * 
+ * @note 在接收任务或轮询接收中调用，直接阻塞发送，t1尽量接近实际发出的时刻；
+ *       收到上位机的第一个有效帧之前不发送，超过SYNC_IDLE没有有效帧时每次把周期加倍，收到后立即恢复
+ */
+void COMM::_syncTick() {
+    if (!m_sync_period || m_baud_pending || !m_rx_stamp) return; // 协商期间链路不可用，没有上位机时不发送
+
+    int64_t now = esp_timer_get_time();
+    bool idle = now - m_rx_stamp > SYNC_IDLE;
+    if (m_sync_backoff && !idle) { // 链路恢复，立即同步
+        m_sync_backoff = 0;
+        m_sync_next = now;
+    }
+    if (now < m_sync_next) return;
+
+    ClockPing ping;
+    ping.seq = ++m_ping_seq;
+    ping.t1 = now;
+    _sendNow(ping);
+
+    if (idle && m_sync_backoff < SYNC_MAX_BACKOFF) m_sync_backoff++;
+    int64_t period = m_ping_seq < SYNC_FAST_NUM ? SYNC_FAST_PERIOD : m_sync_period;
+    m_sync_next = now + (period << m_sync_backoff);
+}
+
+/**
+ * @brief 设置时钟同步周期，默认1s
+ * 
+ * @param ms 周期（ms），0为关闭，此后反馈的时间戳停留在最后一次同步的换算上
+ */
+void COMM::setSyncPeriod(uint32_t ms) {
+    m_sync_period = (int64_t)ms * 1000;
+}
+
+/**
+ * @brief 本机时刻换算为上位机时刻，尚未同步时原样返回
+ */
+int64_t COMM::hostTime(int64_t local) const {
+    return m_clock.toHost(local);
+}
+
+const ClockSync& COMM::getClock() const {
+    return m_clock;
+}
+
+namespace {
+    LatencyStage makeStage(const LatencyHist& hist) {
+        LatencyStage stage;
+        stage.count = hist.count();
+        stage.p50 = hist.percentile(0.5f);
+        stage.p90 = hist.percentile(0.9f);
+        stage.p99 = hist.percentile(0.99f);
+        stage.max = hist.max();
+        return stage;
+    }
+}
+
+/**
+ * @brief 获取接收、处理、发送三个阶段的延迟分布及时钟同步状态
+ * 
+ * @note 接收和处理在接收任务中记录，发送在发送任务中记录，均只在对应任务启动后有数据
+ */
+LatencyReport COMM::getLatencyReport() const {
+    LatencyReport report;
+    report.rx = makeStage(m_hist_rx);
+    report.proc = makeStage(m_hist_proc);
+    report.tx = makeStage(m_hist_tx);
+
+    ClockState clock = m_clock.getState();
+    report.rtt = clock.rtt;
+    report.offset = clock.offset;
+    report.drift = clock.drift * 1e6f;
+    return report;
+}
+
+/**
+ * @brief 清空延迟直方图，应在记录的任务空闲时调用，否则可能残留一次记录
+ */
+void COMM::resetLatency() {
+    m_hist_rx.reset();
+    m_hist_proc.reset();
+    m_hist_tx.reset();
+}
+
+/**
+ * @brief 获取波特率协商失败退回的次数
+ */
+uint32_t COMM::getBaudFallback() const {
+    return m_baud_fallback;
+}
+
+/**
+ * @brief 启动发送任务，此后sendMsg只把帧编码进缓冲区，由发送任务交给串口
+ * 
+ * @param priority 任务优先级，低于控制循环即可
+ * @param core 绑定的核心
+ * @param policy 链路饱和、填充缓冲区满时的策略
+ * 
+ * @note 串口驱动的发送缓冲区可设为0，由发送任务直接写FIFO，省去驱动内的一次拷贝
+ */
+bool COMM::startTxTask(UBaseType_t priority, BaseType_t core, TX_POLICY policy) {
+    if (m_tx_task) return false;
+
+    m_tx_policy = policy;
+    return SYSMON::createTask(_txTask, "commTx", TX_TASK_STACK, this, priority, &m_tx_task, core);
+}
+
+/**
+ * @brief 在填充缓冲区中为一帧分配空间，空间不足时按策略处理
+ * 
+ * @param id 帧的消息ID，合并时用于查找旧帧
+ * @param len 帧长度
+ * @param idx 分配到的缓冲区，编码完成后交给_txCommit
+ * 
+ * @return 帧的写入位置，被丢弃时返回nullptr
+ * 
+ * @note 合并需要逐帧读取帧头，有其他帧正在编码时帧头可能尚未写入，此时不合并，直接丢弃
+ */
+uint8_t* COMM::_txReserve(uint8_t id, size_t len, uint8_t& idx) {
+    idx = m_tx_fill;
+    TxBuffer& buf = m_tx[idx];
+
+    if (buf.len + len <= TX_BUF_SIZE) {
+        if (!buf.len) buf.stamp = esp_timer_get_time();
+        uint8_t* dst = buf.data + buf.len;
+        buf.len += len;
+        buf.writers++;
+        m_tx_stats.frames++;
+        return dst;
+    }
+
+    if (m_tx_policy == TX_COALESCE && !buf.writers) {
+        // 逐帧查找同ID同长度的旧帧，原地覆盖
+        size_t pos = 0;
+        while (pos + PROTOCOL::HEAD_LEN <= buf.len) {
+#if COMM_FRAMING == COMM_FRAMING_COBS
+            // 帧以0x00结尾；ID非0，因此总紧跟在起始码字节之后
+            const uint8_t* end = static_cast<const uint8_t*>(memchr(buf.data + pos, 0x00, buf.len - pos));
+            size_t frameLen = end - (buf.data + pos) + 1;
+            uint8_t frameId = buf.data[pos + 1];
+#else
+            size_t frameLen = PROTOCOL::OVERHEAD + buf.data[pos + 3];
+            uint8_t frameId = buf.data[pos + 2];
+#endif
+            if (frameId == id && frameLen == len) {
+                buf.writers++;
+                m_tx_stats.coalesced++;
+                return buf.data + pos;
+            }
+            pos += frameLen;
+        }
+    }
+
+    m_tx_stats.dropped++;
+    return nullptr;
+}
+
+/**
+ * @brief 一帧在锁外编码完成，撤销_txReserve登记的写者并唤醒发送任务
+ * 
+ * @param idx _txReserve分配到的缓冲区
+ */
+void COMM::_txCommit(uint8_t idx) {
+    portENTER_CRITICAL(&m_tx_lock);
+    m_tx[idx].writers--;
+    portEXIT_CRITICAL(&m_tx_lock);
+
+    xTaskNotifyGive(m_tx_task); // 发送任务可能正在等这一块的写者
+}
+
+/**
+ * @brief 发送任务，被生产者唤醒后交换双缓冲，等换下的一块编码全部完成后交给串口
+ */
+void COMM::_txTask(void* arg) {
+    COMM& comm = *static_cast<COMM*>(arg);
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (true) {
+            portENTER_CRITICAL(&comm.m_tx_lock);
+            uint8_t idx = comm.m_tx_fill;
+            size_t len = comm.m_tx[idx].len;
+            if (len) comm.m_tx_fill = idx ^ 1; // 之后生产者写入另一块
+            portEXIT_CRITICAL(&comm.m_tx_lock);
+
+            if (!len) break;
+
+            while (true) { // 交换前分配到这一块的帧可能还在编码，每完成一帧_txCommit都会通知
+                portENTER_CRITICAL(&comm.m_tx_lock);
+                uint8_t writers = comm.m_tx[idx].writers;
+                portEXIT_CRITICAL(&comm.m_tx_lock);
+                if (!writers) break;
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
+
+            comm.m_uart.write(comm.m_tx[idx].data, len); // 只阻塞发送任务
+            comm.m_hist_tx.record(esp_timer_get_time() - comm.m_tx[idx].stamp);
+            comm.m_tx[idx].len = 0; // 交换前另一块一定已发完并清空
+        }
+    }
+}
+
+/**
+ * @brief 获取发送统计
+ */
+TxStats COMM::getTxStats() const {
+    portENTER_CRITICAL(&m_tx_lock);
+    TxStats stats = m_tx_stats;
+    portEXIT_CRITICAL(&m_tx_lock);
+    return stats;
 }
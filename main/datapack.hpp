@@ -1,39 +1,295 @@
 #ifndef DATAPACK_HPP
 #define DATAPACK_HPP
 
-#include "uart.hpp"
+#include "transport.hpp"
 #include "uart_data_pack.hpp"
+#include "crc16.hpp"
+#include "protocol.hpp"
+#include "ring_buffer.hpp"
+#include "histogram.hpp"
+#include "clock_sync.hpp"
+#include "mailbox.hpp"
+#include "sysmon.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+// 接收延迟统计（us），从帧的最后一个字节到达到消息分发给处理者
+struct RxLatency
+{
+    uint32_t last = 0; // 最近一次
+    uint32_t max = 0; // 最大值
+    uint64_t sum = 0; // 累计值，与cnt一起求平均
+    uint32_t cnt = 0; // 统计次数
+};
+
+// 可靠通道的确认状态，随反馈发给上位机
+struct AckState
+{
+    uint16_t seq = 0; // 收到的最新可靠序号
+    uint32_t bits = 0; // bit i 为1表示序号 seq-1-i 已收到
+};
+
+// 发送队列满时的处理策略
+enum TX_POLICY : uint8_t {
+    TX_DROP,     // 丢弃新帧
+    TX_COALESCE, // 用新帧覆盖队列中同ID的旧帧，找不到时丢弃
+};
+
+// 发送统计
+struct TxStats
+{
+    uint32_t frames = 0; // 进入发送缓冲区的帧数
+    uint32_t dropped = 0; // 丢弃的帧数
+    uint32_t coalesced = 0; // 被合并的帧数
+};
 
 /**
  * @brief 通讯类，负责通过串口发送反馈和通过串口接受指令
  * 
- * @param uartClass 使用的串口对象
+ * @param transport 使用的传输对象，目标板上为Uart，linux目标上为PtyTransport，见transport.hpp
+ * 
+ * @note 消息收发：sendMsg发送任意注册的消息；receMsgs解出所有完整的帧，按ID分发给处理者的onMsg
+ *       接收可以轮询receMsgs，也可以用startRxTask启动接收任务，由串口事件唤醒立即解包，二者不可同时使用
+ *       启动startTxTask后sendMsg不再阻塞，帧直接编码进双缓冲，由发送任务交给串口
+ *       可靠通道：带RELIABLE标记的消息（如RoBoCmd）按序号去重，确认位图随uartSendPack的反馈带回，见uart_data_pack.hpp
+ *       时钟同步：收到上位机的有效帧后，linkTick周期地向上位机发送ClockPing，链路静默时逐步拉长周期，uartSendPack发出的反馈带上位机时钟的时间戳；
+ *       上位机发来的ClockPing同样会被应答，供上位机测量往返延迟
  */
 class COMM {
     public:
-        COMM(Uart& uartClass);
+        static constexpr uint32_t RX_TASK_STACK = 4096; // 接收任务栈大小
+        static constexpr uint32_t TX_TASK_STACK = 3072; // 发送任务栈大小
+
+        COMM(Transport& transport);
         ~COMM();
 
-        bool uartSendPack(RoBoFeedBack& pack);
+        bool uartSendPack(const RoBoFeedBack& pack);
         bool uartRecePack(RoBoCmd& packBuf);
+        size_t uartRecePack(RoBoCmd* packBuf, size_t maxNum);
+
+        template <class T>
+        bool sendMsg(const T& msg); // 编码并发送一个消息
+        template <class Handler, class... Msgs>
+        size_t receMsgs(Handler& handler, MsgList<Msgs...>); // 接收并分发所有完整的消息
+        template <class Handler, class... Msgs>
+        bool startRxTask(Handler& handler, MsgList<Msgs...>, UBaseType_t priority, BaseType_t core = tskNO_AFFINITY); // 启动事件驱动的接收任务
+
+        bool startTxTask(UBaseType_t priority, BaseType_t core = tskNO_AFFINITY, TX_POLICY policy = TX_COALESCE); // 启动非阻塞发送任务
+        TxStats getTxStats() const; // 发送统计
+
+        int64_t getRxStamp() const; // 当前消息的到达时刻
+        RxLatency getRxLatency() const; // 接收延迟统计
+        uint32_t getRxOverflow() const; // 接收溢出次数
+        uint32_t getRxCrcErrors() const; // 校验失败次数
+        uint32_t getRxDuplicate() const; // 被去重的可靠消息数
+        uint32_t getRxStale() const; // 过期被丢弃的可靠消息数
+        AckState getAckState() const; // 可靠通道的确认状态
+
+        void setSyncPeriod(uint32_t ms); // 时钟同步周期，0为关闭
+        int64_t hostTime(int64_t local) const; // 本机时刻换算为上位机时刻
+        const ClockSync& getClock() const; // 时钟同步状态
+        LatencyReport getLatencyReport() const; // 各阶段延迟分布，可直接sendMsg给上位机
+        void resetLatency(); // 清空延迟直方图
+
+        void setMaxBaud(uint32_t baud); // 允许上位机协商的最高波特率
+        void linkTick(); // 检查波特率协商超时，轮询模式下需周期调用
+        uint32_t getBaudFallback() const; // 协商失败退回的次数
     private:
-        Uart& m_uart; // 传入的串口对象
-        uint8_t packStatus; // 解包标志位
-        size_t rx_cnt; // 记录已接受的字节数
-        static const uint16_t crc16Table[256]; // CRC-16/MODBUS查找表
-        
+        Transport& m_uart; // 传入的传输对象
+
+        // 接收任务
+        TaskHandle_t m_rx_task; // 接收任务句柄
+        void* m_rx_handler; // 接收任务使用的处理者
+        size_t (*m_rx_thunk)(COMM&, void*); // 以具体类型调用receMsgs
+        int64_t m_rx_wake; // 接收任务被串口事件唤醒的时刻，事件后的第一次读取以此为到达时刻，用过后清零
+        int64_t m_rx_stamp; // 当前分发的帧的到达时刻
+        RxLatency m_rx_lat; // 接收延迟统计，只在接收侧更新
+        Mailbox<RxLatency> m_rx_lat_pub; // 发布的接收延迟统计
+        uint32_t m_rx_overflow; // 接收溢出次数
+        uint32_t m_rx_crc_err; // 校验失败次数
+        uint32_t m_rx_dup; // 被去重的可靠消息数
+        uint32_t m_rx_stale; // 过期被丢弃的可靠消息数
+
+        // 可靠通道，m_ack_seq/m_ack_bits只在接收侧读写，经m_ack发布给发送反馈的任务
+        uint16_t m_ack_seq; // 收到的最新可靠序号，0为尚未收到
+        uint32_t m_ack_bits; // 之前32个序号的接收位图
+        Mailbox<AckState> m_ack; // 发布的确认状态
+        AckState m_ack_sent; // 上次随反馈发出的确认状态，只在发送反馈的任务中读写
+
+        // 延迟直方图（us）
+        LatencyHist m_hist_rx; // 帧到达到分发
+        LatencyHist m_hist_proc; // 处理者耗时
+        LatencyHist m_hist_tx; // 进入发送缓冲区到交给串口驱动
+
+        // 发送双缓冲，生产者写入填充缓冲区，发送任务交换后发出另一块
+        static constexpr size_t TX_BUF_SIZE = 1024; // 单块缓冲区大小
+        struct TxBuffer {
+            uint8_t data[TX_BUF_SIZE];
+            size_t len = 0;
+            int64_t stamp = 0; // 第一帧进入的时刻
+            uint8_t writers = 0; // 已分配空间、尚在锁外编码的帧数，为0后发送任务才能发出这一块
+        };
+        TxBuffer m_tx[2];
+        uint8_t m_tx_fill; // 当前填充的缓冲区
+        TX_POLICY m_tx_policy; // 填充缓冲区满时的策略
+        TxStats m_tx_stats; // 发送统计
+        TaskHandle_t m_tx_task; // 发送任务句柄，为空时sendMsg直接阻塞发送
+        mutable portMUX_TYPE m_tx_lock; // 保护填充缓冲区分配和发送统计的自旋锁，编码在锁外进行
+
+        // 波特率协商
+        static constexpr int64_t BAUD_CONFIRM_TIMEOUT = 500000; // 等待上位机以新波特率确认的超时（us）
+        static constexpr uint32_t BAUD_MIN = 9600; // 允许的最低波特率
+        static constexpr TickType_t LINK_TICK = pdMS_TO_TICKS(50); // 接收任务检查协商超时的周期
+        uint32_t m_max_baud; // 允许协商的最高波特率
+        uint32_t m_baud_prev; // 协商前的波特率，超时退回
+        uint32_t m_baud_pending; // 等待确认的新波特率，0表示没有进行中的协商
+        int64_t m_baud_deadline; // 确认截止时刻
+        uint32_t m_baud_fallback; // 协商失败退回的次数
+
+        // 时钟同步
+        static constexpr int64_t SYNC_FAST_PERIOD = 100000; // 启动阶段的同步周期（us），尽快得到第一个窗口
+        static constexpr uint32_t SYNC_FAST_NUM = 8; // 启动阶段的同步次数
+        static constexpr int64_t SYNC_IDLE = 3000000; // 超过该时间（us）没有收到有效帧视为链路断开，开始退避
+        static constexpr uint8_t SYNC_MAX_BACKOFF = 5; // 退避时同步周期最多放大到 2^5 倍
+        ClockSync m_clock; // 偏移和漂移估计
+        int64_t m_sync_period; // 同步周期（us），0为关闭
+        int64_t m_sync_next; // 下一次发送ClockPing的时刻
+        uint8_t m_sync_backoff; // 当前退避的倍数（2的幂次）
+        uint32_t m_ping_seq; // 最近一次ClockPing的序号
+
         // 缓冲区
-        static constexpr size_t RX_TEMP_BUFFER_SIZE = 64; // 从串口单次读取的临时缓冲区大小
-        static constexpr size_t RX_PACKET_BUFFER_SIZE = 256; // 组包缓冲区大小
-        uint8_t m_rx_temp_buf[RX_TEMP_BUFFER_SIZE]; // 接受缓冲区
-        uint8_t m_rx_packet_buf[RX_PACKET_BUFFER_SIZE]; // 组包缓冲区
+        static constexpr size_t RX_RING_SIZE = 512; // 接收环形缓冲区大小，至少能放下一个最长帧
+        ByteRing<RX_RING_SIZE> m_rx_ring; // 接收环形缓冲区，保存尚未解出的字节
+        uint8_t m_rx_frame[PROTOCOL::MAX_FRAME + PROTOCOL::COBS_OVERHEAD]; // 当前解出的帧，COBS格式下先放编码数据再原地解码
+
+        // 环形缓冲区开头正在接收的帧，跨多次接收保留，每个字节只拷贝、解码和计入CRC一次
+        struct RxParse {
+            size_t in = 0; // 已处理的线路字节数，帧头格式下为0表示尚未找到帧头
+            size_t out = 0; // COBS已解码的帧体字节数
+            size_t crcLen = 0; // COBS已计入CRC的帧字节数
+            uint16_t crc = CRC16::INIT; // 运行中的CRC
+            uint8_t left = 0; // COBS当前块剩余的数据字节数
+            bool zero = false; // COBS当前块之后有被替换掉的0x00
+        };
+        RxParse m_rx_parse;
+
+        // 最近几次读取的到达时刻，帧的到达时刻取读入其最后一个字节的那次读取
+        static constexpr size_t RX_MARKS = 4; // 记录的读取次数，一次_fillRing最多读取两次
+        struct RxMark {
+            uint32_t end = 0; // 这次读取之后累计读入的字节数
+            int64_t stamp = 0; // 到达时刻，0为未使用
+        };
+        RxMark m_rx_marks[RX_MARKS];
+        uint8_t m_rx_mark; // 最近一次读取的下标
+        uint32_t m_rx_total; // 累计读入的字节数，回绕
 
-        // 解包标志位定义
-        static constexpr uint8_t WAITING_FOR_HEADER_1 = 0; // 准备接受包头部分1
-        static constexpr uint8_t WAITING_FOR_HEADER_2 = 1; // 准备接受包头部分2
-        static constexpr uint8_t RECEIVING_DATA = 2; // 正在接受数据和校验和
+        bool _fillRing(); // 从串口读取数据到环形缓冲区
+        bool _nextFrame(uint8_t& id, const uint8_t*& payload, size_t& len); // 取出下一个通过校验的帧
+        void _clearRx(); // 清空接收缓冲区和解析状态
+        int64_t _frameStamp() const; // 刚取出的帧的到达时刻
+        void _recordLatency(int64_t now); // 记录一次接收延迟
+        void _syncTick(); // 到期时发送ClockPing
+        bool _linkMsg(uint8_t id, const uint8_t* payload, size_t len); // 处理链路控制消息
+        bool _acceptSeq(uint16_t seq); // 登记可靠序号，重复的返回false
+        static void _rxTask(void* arg); // 接收任务
+        uint8_t* _txReserve(uint8_t id, size_t len, uint8_t& idx); // 在填充缓冲区中为一帧分配空间，需持有m_tx_lock
+        void _txCommit(uint8_t idx); // 一帧编码完成，唤醒发送任务
+        static void _txTask(void* arg); // 发送任务
 
-        uint16_t _createCRC16(const void* bytesBuf, size_t len) const; //计算16位CRC
+        template <class T>
+        bool _sendNow(const T& msg); // 绕过发送队列直接阻塞发送
 };
 
+/**
+ * @brief 编码并发送一个消息
+ * 
+ * @note 发送任务启动后，在锁内为帧分配空间，在锁外直接编码进填充缓冲区，不会阻塞；缓冲区满时按策略丢弃或合并
+ * 
+ * @return 帧已发送或已进入发送缓冲区返回true，被丢弃返回false
+ */
+template <class T>
+bool COMM::sendMsg(const T& msg) {
+    if (!m_tx_task) return _sendNow(msg);
+
+    uint8_t idx;
+    portENTER_CRITICAL(&m_tx_lock);
+    uint8_t* dst = _txReserve(T::ID, PROTOCOL::WIRE_OVERHEAD + PROTOCOL::msgSize(msg), idx);
+    portEXIT_CRITICAL(&m_tx_lock);
+    if (!dst) return false;
+
+    PROTOCOL::encodeWire(msg, dst); // 编码和CRC不关中断，发送任务等这一块的编码全部完成才发出
+    _txCommit(idx);
+    return true;
+}
+
+template <class T>
+bool COMM::_sendNow(const T& msg) {
+    uint8_t buf[PROTOCOL::WIRE_OVERHEAD + sizeof(T)];
+    size_t len = PROTOCOL::encodeWire(msg, buf);
+    return m_uart.write(buf, len); // 发送
+}
+
+/**
+ * @brief 从串口收取一次数据，解出其中所有完整的帧，按消息ID查表分发给handler.onMsg
+ * 
+ * @param handler 处理者，为每种注册的消息提供 void onMsg(const T&)
+ * @param MsgList 注册的消息列表
+ * 
+ * @return 分发的消息数，未注册的ID被丢弃
+ */
+template <class Handler, class... Msgs>
+size_t COMM::receMsgs(Handler& handler, MsgList<Msgs...>) {
+    size_t num = 0;
+    uint8_t id;
+    const uint8_t* payload;
+    size_t len;
+
+    bool more;
+    uint32_t latCnt = m_rx_lat.cnt;
+
+    do {
+        more = _fillRing(); // 环形缓冲区被填满时串口中可能还有数据，解包腾出空间后继续读
+        while (_nextFrame(id, payload, len)) {
+            m_rx_stamp = _frameStamp();
+            if (_linkMsg(id, payload, len)) continue;
+            uint16_t seq = MsgDispatch<Handler, Msgs...>::seq(id, payload, len);
+            if (seq && !_acceptSeq(seq)) continue; // 上位机重发的可靠消息，已处理过
+            int64_t start = esp_timer_get_time();
+            _recordLatency(start);
+            if (MsgDispatch<Handler, Msgs...>::dispatch(handler, id, payload, len)) {
+                m_hist_proc.record(esp_timer_get_time() - start);
+                num++;
+            }
+        }
+    } while (more);
+
+    if (m_rx_lat.cnt != latCnt) m_rx_lat_pub.write(m_rx_lat); // 每次接收只发布一次
+
+    linkTick();
+    return num;
+}
+
+/**
+ * @brief 启动接收任务，任务阻塞在串口事件队列上，有数据到达即解包并分发给handler.onMsg
+ * 
+ * @param handler 处理者，为每种注册的消息提供 void onMsg(const T&)，在接收任务中被调用
+ * @param MsgList 注册的消息列表
+ * @param priority 任务优先级
+ * @param core 绑定的核心
+ * 
+ * @note 数据多快到达事件队列由 Uart::setRxThreshold 决定
+ */
+template <class Handler, class... Msgs>
+bool COMM::startRxTask(Handler& handler, MsgList<Msgs...>, UBaseType_t priority, BaseType_t core) {
+    if (m_rx_task) return false;
+
+    m_rx_handler = &handler;
+    m_rx_thunk = [](COMM& comm, void* h) -> size_t {
+        return comm.receMsgs(*static_cast<Handler*>(h), MsgList<Msgs...>{});
+    };
+
+    return SYSMON::createTask(_rxTask, "commRx", RX_TASK_STACK, this, priority, &m_rx_task, core);
+}
+
 #endif
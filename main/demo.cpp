@@ -4,50 +4,56 @@
 I2C i2c(I2C_NUM_0, 15, 16); // 实例化化IIC
 ICM20948 icm20948(i2c); // 实例化ICM20948传感器
 Flash flash_nvs; // 实例化NVS
+ParamStore params(flash_nvs); // NVS中的参数，读取走RAM缓存
+ParamStore::Param<ImuCali> imuCali(params, "imuCali", IMU_CALI_VERSION); // IMU校准数据
+UartConfig uartConfig = [] {
+    UartConfig config;
+    config.tx_buffer_size = 0; // 只由COMM发送任务写串口，直接写FIFO，省去驱动发送缓冲区的一次拷贝
+    return config;
+}();
+Uart uart(UART_NUM_1, 17, 18, uartConfig); // 实例化串口，用于发送二进制日志
+COMM comm(uart); // 实例化通讯
+StillDetector bootStill; // 开机校准验证用的静止检测器
+FlightLog flightLog; // 黑匣子，写入flightlog分区
+const adc_channel_t powerChannels[] = {ADC_CHANNEL_0}; // 电池分压，ESP32-S3上为GPIO1
+AdcMeterConfig powerCfg = {{5000, ADC_ATTEN_DB_12, 4}, 50}; // 5kHz采样，抽取到100Hz
+AdcMeter powerMeter(ADC_UNIT_1, powerChannels, 1, powerCfg); // 电池电压测量
+SemaphoreHandle_t nvsReady; // NVS初始化完成信号
+StaticSemaphore_t nvsReadyBuf;
 
 /* 传感器lsb */
 namespace PARAMS {
     double ACCEL_LSB = 8192.0;
     double GYRO_LSB = 65.534;
+    const double CALI_GYRO_TOL = 0.5; // 存储零偏与实测零偏的允许偏差（°/s）
+    const double CALI_GRAVITY_TOL = 0.05; // 校准后重力模长与1g的允许相对偏差
+    const int STILL_CHECK_MS = 300; // 开机静止检测的超时时间
+    const gpio_num_t IMU_INT_PIN = GPIO_NUM_NC; // ICM的INT引脚，接线后改为对应GPIO以数据就绪中断驱动采集
+    const float IMU_ODR = 1125.0f; // ICM陀螺仪和加速度计不分频时的输出频率
+    const int BAT_DIVIDER = 11; // 电池分压比（100k/10k）
+}
+
+/* 本程序创建的任务，静态分配模式下栈之和不能超过内存池，新增任务时在此登记 */
+namespace TASKS {
+    constexpr uint32_t DEMO_STACK = 4096; // 开机初始化任务
+    constexpr uint32_t NVS_INIT_STACK = 4096; // NVS初始化任务
+    constexpr PipelineConfig PIPE{}; // 流水线各阶段使用默认栈大小
+    constexpr uint32_t STACK_SUM = DEMO_STACK + NVS_INIT_STACK + COMM::TX_TASK_STACK + COMM::RX_TASK_STACK +
+        TRACE::DRAIN_TASK_STACK + FlightLog::WRITER_STACK + FlightLog::DUMP_STACK +
+        PIPE.acq.stack + PIPE.fusion.stack + PIPE.comm.stack + SYSMON::REPORT_TASK_STACK + AdcStream::TASK_STACK;
+    // 不依赖退出任务的回收，全部同时存在也放得下
+    static_assert(!STATIC_ALLOC || STACK_SUM <= STATIC_TASK_POOL, "STATIC_TASK_POOL is smaller than the task stacks");
 }
 
 /* 工具函数 */
 namespace UTILS {
-    bool caliGyro(Vec3i& rawGyroBias) { // 一定在陀螺仪初始化后使用
-        Vec3li sum; //使用长整型，防止溢出
-        Vec3i buf; // 暂存数据
-
-        ESP_LOGI("GyroCail", "Start !");
-        for (int cnt = 0; cnt < 1000; cnt++) {
-            if (icm20948.readGyro(buf)) {
-                sum.x += buf.x;
-                sum.y += buf.y;
-                sum.z += buf.z;
-
-                delay_ms(2);
-            }
-            else {
-                ESP_LOGE("GyroCail", "dsiconnection !");
-                return false;
-            }
-        }
-
-        rawGyroBias.x = sum.x / 1000;
-        rawGyroBias.y = sum.y / 1000;
-        rawGyroBias.z = sum.z / 1000;
-
-        ESP_LOGI("GyroCail", "Success !\nGyroBias: %d  %d  %d", rawGyroBias.x, rawGyroBias.y, rawGyroBias.z);
-
-        return true;
-    }
-
     bool caliAccel(Vec3i& rawAccelBias, Vec3lf& rawAccelGain) {
         Vec3i buf; // 暂存数据
         long sum = 0; // 存储测量和
         int mean[6]; // 存储平均值
         int temp[3]; // 辅助索引存储
         double lsb = PARAMS::ACCEL_LSB;
-        const std::string tag[6] = {
+        const char* const tag[6] = {
             "X+", "X-", "Y+", "Y-", "Z+", "Z-"
         };
 
@@ -61,7 +67,7 @@ namespace UTILS {
         int tempIndex = 0;
         int sign = 1;
         for (int i = 0; i < 6; i++) {
-            ESP_LOGI("AccelCali", "Pose: %s", tag[i].c_str());
+            ESP_LOGI("AccelCali", "Pose: %s", tag[i]);
             for (int j = 0; j < 1000; j++) {
                 if (!icm20948.readAccel(buf)) {
                     ESP_LOGE("AccelCail", "dsiconnection !");
@@ -103,13 +109,141 @@ namespace UTILS {
 
         return true;
     }
+
+    bool readImu(Vec3lf& gyro, Vec3lf& accel) { // 读取一次陀螺仪（°/s）和加速度计（原始值）
+        Vec3i rawGyro, rawAccel;
+        {
+            PROBE_SCOPE(GYRO_READ);
+            if (!icm20948.readGyro(rawGyro)) return false;
+        }
+        {
+            PROBE_SCOPE(ACCEL_READ);
+            if (!icm20948.readAccel(rawAccel)) return false;
+        }
+
+        gyro.x = rawGyro.x / PARAMS::GYRO_LSB;
+        gyro.y = rawGyro.y / PARAMS::GYRO_LSB;
+        gyro.z = rawGyro.z / PARAMS::GYRO_LSB;
+        accel.x = rawAccel.x;
+        accel.y = rawAccel.y;
+        accel.z = rawAccel.z;
+        return true;
+    }
+
+    bool readMag(Vec3lf& mag) { // 读取一次磁力计（原始值）
+        Vec3i rawMag;
+        if (!icm20948.readMag(rawMag)) return false;
+
+        mag.x = rawMag.x;
+        mag.y = rawMag.y;
+        mag.z = rawMag.z;
+        return true;
+    }
+
+    uint8_t batteryStatus() { // 反馈包status：电池电压，单位0.1V，最大25.5V，尚无测量时为0
+        int mv;
+        if (!powerMeter.getMv(0, mv)) return 0;
+        int dv = (mv * PARAMS::BAT_DIVIDER + 50) / 100;
+        return dv > 255 ? 255 : dv;
+    }
+
+    /* 在超时时间内等待一个静止窗口，成功时输出窗口内陀螺仪均值和加速度计均值 */
+    bool waitStill(int timeoutMs, Vec3lf& gyroMean, Vec3lf& accelMean) {
+        Vec3lf gyro, accel;
+        Vec3lf accelSum;
+        int n = 0;
+
+        bootStill.reset();
+        for (int t = 0; t < timeoutMs; t++) {
+            if (!readImu(gyro, accel)) return false;
+            accelSum.x += accel.x;
+            accelSum.y += accel.y;
+            accelSum.z += accel.z;
+            n++;
+
+            if (bootStill.update(gyro, accel)) {
+                gyroMean = bootStill.gyroMean();
+                accelMean.x = accelSum.x / n;
+                accelMean.y = accelSum.y / n;
+                accelMean.z = accelSum.z / n;
+                return true;
+            }
+            if (n == (int)StillDetector::WINDOW) { // 只统计最近不超过一个窗口的加速度
+                accelSum = {};
+                n = 0;
+            }
+            delay_ms(1);
+        }
+        return false;
+    }
+
+    /**
+     * 用一次短静止检测验证存储的校准数据，静止时要求零偏吻合且校准后重力为1g
+     * 开机时若未静止则无法验证，沿用存储数据，零偏交由AHRS后台修正
+     */
+    bool checkCali(const ImuCali& cali) {
+        Vec3lf gyroMean, accelMean;
+        if (!waitStill(PARAMS::STILL_CHECK_MS, gyroMean, accelMean)) {
+            ESP_LOGW("Boot", "Not still, skip validation !");
+            return true;
+        }
+
+        if (fabs(gyroMean.x - cali.gyroBias.x) > PARAMS::CALI_GYRO_TOL ||
+            fabs(gyroMean.y - cali.gyroBias.y) > PARAMS::CALI_GYRO_TOL ||
+            fabs(gyroMean.z - cali.gyroBias.z) > PARAMS::CALI_GYRO_TOL) return false;
+
+        double x = (accelMean.x - cali.accelBias.x) / cali.accelGain.x;
+        double y = (accelMean.y - cali.accelBias.y) / cali.accelGain.y;
+        double z = (accelMean.z - cali.accelBias.z) / cali.accelGain.z;
+        double g = sqrt(x * x + y * y + z * z) / PARAMS::ACCEL_LSB;
+        return fabs(g - 1.0) < PARAMS::CALI_GRAVITY_TOL;
+    }
+
+    /* 完整校准：等待静止取陀螺仪零偏，再做加速度计六面校准 */
+    bool fullCali(ImuCali& cali) {
+        Vec3lf accelMean;
+        ESP_LOGI("GyroCali", "Keep still !");
+        while (!waitStill(1000, cali.gyroBias, accelMean)) {
+            ESP_LOGW("GyroCali", "Not still !");
+        }
+        ESP_LOGI("GyroCali", "GyroBias: %lf %lf %lf", cali.gyroBias.x, cali.gyroBias.y, cali.gyroBias.z);
+
+        return caliAccel(cali.accelBias, cali.accelGain);
+    }
+}
+
+/* 上位机请求处理者，在接收任务中被调用 */
+struct LinkHandler {
+    void onMsg(const LogDumpReq& req) {
+        (void) req;
+        if (!flightLog.requestDump()) ESP_LOGW("FlightLog", "Dump busy !");
+    }
+} linkHandler;
+
+/* NVS初始化任务，与I2C和ICM初始化并行，完成后把参数读入缓存 */
+void nvsInit(void *pvParameters) {
+    (void) pvParameters;
+
+    if (flash_nvs.init()) {
+        ESP_LOGI("NVS", "NVS Init !");
+        params.load();
+        if (!flash_nvs.mapConfig()) ESP_LOGW("Config", "No config partition !"); // 出厂配置区可选
+    }
+    else {
+        ESP_LOGE("NVS", "NVS Init Fail !");
+    }
+
+    xSemaphoreGive(nvsReady);
+    SYSMON::exitTask();
 }
 
 /* 创建RTOS任务函数 */ 
 void demo(void *pvParameters) {
     (void) pvParameters; // 告诉编译器我知道这个没有别警告我
 
-    /* 初始化各外设 */
+    /* 初始化各外设，NVS在独立任务中并行初始化 */
+    SYSMON::createTask(nvsInit, "nvsInit", TASKS::NVS_INIT_STACK, NULL, 1);
+
     if (i2c.init()) {
         ESP_LOGI("I2C", "I2C Init !");
     }
@@ -125,65 +259,91 @@ void demo(void *pvParameters) {
         ESP_LOGE("ICM", "ICM Init Fail !");
     }
 
-    /* 初始化NVS */
-    if (flash_nvs.init()) {
-        ESP_LOGI("NVS", "NVS Init !");
+    /* 初始化串口，二进制日志经COMM发出，由 tools/trace_fmt.py 格式化 */
+    if (uart.init()) {
+        ESP_LOGI("UART", "UART Init !");
     }
     else {
-        ESP_LOGE("NVS", "NVS Init Fail !");
+        ESP_LOGE("UART", "UART Init Fail !");
+    }
+    comm.startTxTask(2, 0, TX_DROP); // 日志不能被同ID的新帧覆盖
+    TRACE::startDrain(comm, 1, 0);
+
+    xSemaphoreTake(nvsReady, portMAX_DELAY);
+
+    /* 优先使用NVS中的校准数据，验证失败才完整校准 */
+    ImuCali cali = imuCali;
+    if (imuCali.isLoaded() && UTILS::checkCali(cali)) {
+        ESP_LOGI("Boot", "Calibration loaded !");
+        TRACE(CALI_LOADED);
+    }
+    else if (const ImuCali* factory = flash_nvs.getTable<ImuCali>(CFG_IMU_CALI, IMU_CALI_VERSION);
+             factory && UTILS::checkCali(*factory)) { // 出厂校准直接从映射的flash读取
+        cali = *factory;
+        ESP_LOGI("Boot", "Factory calibration loaded !");
+        TRACE(CALI_LOADED);
+    }
+    else {
+        ESP_LOGW("Boot", "Calibration invalid, recalibrate !");
+        TRACE(CALI_FAIL);
+        if (!UTILS::fullCali(cali)) ESP_LOGE("Cali", "Cali Fail !");
+        else {
+            imuCali.set(cali);
+            if (params.commit()) ESP_LOGI("NVS", "Calibration saved in key imuCali !");
+            else ESP_LOGE("NVS", "Calibration save failed !");
+        }
+    }
+
+    /* 姿态估计，加速度计校准数据与读数同为原始值，流水线任务启动后本任务退出，因此放在静态区 */
+    Vec3lf accelBias = {(double)cali.accelBias.x, (double)cali.accelBias.y, (double)cali.accelBias.z};
+    static AHRS ahrs(cali.gyroBias, accelBias, cali.accelGain);
+
+    /* 采集、融合绑定核心1，通讯与串口发送在核心0，IMU读取和融合不受串口影响 */
+    static Pipeline pipeline(UTILS::readImu, ahrs, comm, UTILS::readMag);
+    PipelineConfig cfg;
+
+    /* 接有INT引脚时以数据就绪中断的时刻作为采样时间戳，采集频率跟随传感器 */
+    if (PARAMS::IMU_INT_PIN != GPIO_NUM_NC) {
+        static GPIO imuInt(PARAMS::IMU_INT_PIN, GPIO_MODE_INPUT, 0, GPIO_DIS, GPIO_INTR_POSEDGE);
+        if (imuInt.init() && icm20948.enableDataReady() && pipeline.setDataReady(imuInt)) {
+            cfg.hz = PARAMS::IMU_ODR;
+            ESP_LOGI("ICM", "Data ready interrupt enabled !");
+        }
+        else {
+            ESP_LOGE("ICM", "Data ready interrupt Fail !");
+        }
+    }
+
+    /* 黑匣子写入和回放都在核心0的低优先级任务中。擦写flash时两个核心的cache都被关闭，核心1的采集和融合
+       同样会停住，靠sdkconfig.defaults中的flash自动挂起把停顿缩短到几十us，见main/flight_log.hpp */
+    if (flightLog.init() && flightLog.startWriter(1, 0) && flightLog.startDumper(comm, 1, 0)) {
+        pipeline.setLogger(flightLog);
+        ESP_LOGI("FlightLog", "FlightLog Init, %u records !", (unsigned)flightLog.capacity());
+    }
+    else {
+        ESP_LOGE("FlightLog", "FlightLog Init Fail !");
     }
 
-    /*  陀螺仪零偏 */
-    Vec3i rawGyroBias;
-
-    /* 加速度计零偏和缩放 */
-    Vec3i rawAccelBias;
-    Vec3lf rawAccelGain;
-
-    /* 校准 */
-    if (!UTILS::caliGyro(rawGyroBias)) ESP_LOGE("GyroCali", "GyroCali Fail !"); // 陀螺仪零偏校准
-    if (!UTILS::caliAccel(rawAccelBias, rawAccelGain)) ESP_LOGE("AccelCali", "AccelCali Fail !"); // 加速度计校准
-
-    /* 存入NVS */
-    if(flash_nvs.saveAsBlob("rawGyroBias", &rawGyroBias, sizeof(rawGyroBias)))
-        ESP_LOGI("NVS", "GyroBias saved in key rawGyroBias !");
-    else
-        ESP_LOGI("NVS", "GyroBias save failed !");
-    if(flash_nvs.saveAsBlob("rawAccelBias", &rawAccelBias, sizeof(rawAccelBias)))
-        ESP_LOGI("NVS", "AccelBias saved in key rawAccelBias !");
-    else
-        ESP_LOGI("NVS", "AccelBias save failed !");
-    if(flash_nvs.saveAsBlob("rawAccelGain", &rawAccelGain, sizeof(rawAccelGain)))
-        ESP_LOGI("NVS", "AccelGain saved in key rawAccelGain !");
-    else
-        ESP_LOGI("NVS", "AccelGain save failed !");
-
-    /* 初始化任务循环控制类 */
-    Rate rate(1);
-
-    /*  nvs陀螺仪零偏 */
-    Vec3i _rawGyroBias;
-    /* nvs加速度计零偏和缩放 */
-    Vec3i _rawAccelBias;
-    Vec3lf _rawAccelGain;
-    /* 重新从nvs中读取来进行验证 */
-    size_t len;
-    len = sizeof(_rawGyroBias);
-    flash_nvs.readAsBlob("rawGyroBias", &_rawGyroBias, &len);
-    len = sizeof(_rawAccelBias);
-    flash_nvs.readAsBlob("rawAccelBias", &_rawAccelBias, &len);
-    len = sizeof(_rawAccelGain);
-    flash_nvs.readAsBlob("rawAccelGain", &_rawAccelGain, &len);
-    while (1)
-    {
-        ESP_LOGI("GyroBias", "%lf, %lf, %lf", _rawGyroBias.x / PARAMS::GYRO_LSB, _rawGyroBias.y / PARAMS::GYRO_LSB, _rawGyroBias.z / PARAMS::GYRO_LSB);
-        ESP_LOGI("AccelBias", "%lf, %lf, %lf", _rawAccelBias.x / PARAMS::ACCEL_LSB, _rawAccelBias.y / PARAMS::ACCEL_LSB, _rawAccelBias.z / PARAMS::ACCEL_LSB);
-        ESP_LOGI("AccelGain", "%lf, %lf, %lf", _rawAccelGain.x / PARAMS::ACCEL_LSB, _rawAccelGain.y / PARAMS::ACCEL_LSB, _rawAccelGain.z / PARAMS::ACCEL_LSB);
-
-        rate.sleep(); // 控制循环频率
+    /* 电池电压经DMA连续采样，采样任务在核心0，滤波后的电压放进反馈包的status */
+    if (powerMeter.init() && powerMeter.start(2, 0)) {
+        pipeline.setStatus(UTILS::batteryStatus);
+        ESP_LOGI("Power", "Power meter Init, %lu Hz%s !", (unsigned long)powerMeter.getOutputHz(),
+            powerMeter.isCalibrated() ? "" : ", uncalibrated");
+    }
+    else {
+        ESP_LOGE("Power", "Power meter Init Fail !");
     }
+    comm.startRxTask(linkHandler, MsgList<LogDumpReq>{}, 4, 0); // 上位机发LogDumpReq回放黑匣子
+
+    if (!pipeline.start(cfg)) ESP_LOGE("Pipeline", "Pipeline Start Fail !");
+
+    /* 之后不应再有堆分配，每10s报告一次堆和各任务栈水位 */
+    SYSMON::startReport(10000, 1, 0);
+    SYSMON::markStartup();
+    SYSMON::exitTask();
 }
 
 extern "C" void app_main(void) {
-    xTaskCreate(demo, "demo", 4096, NULL, 1, NULL); // 创建RTOS任务
+    nvsReady = xSemaphoreCreateBinaryStatic(&nvsReadyBuf);
+    SYSMON::createTask(demo, "demo", TASKS::DEMO_STACK, NULL, 1); // 开机初始化和校准，完成后启动流水线
 }
@@ -0,0 +1,351 @@
+#include "flight_log.hpp"
+#include "datapack.hpp"
+#include "crc16.hpp"
+#include "sysmon.hpp"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include <cstring>
+
+namespace {
+    constexpr const char* TAG = "FlightLog"; // 日志标签
+    constexpr uint32_t SECTOR_MAGIC = 0x474F4C46; // "FLOG"
+    constexpr size_t PAGES_PER_SECTOR = FlightLog::SECTOR_SIZE / FlightLog::PAGE_SIZE;
+    constexpr size_t RECORD_CRC_LEN = offsetof(FlightRecord, crc); // 记录中CRC覆盖的长度
+    constexpr TickType_t WRITER_PERIOD = pdMS_TO_TICKS(100); // 写入任务没有被唤醒时检查预擦除的周期
+
+    // 扇区头，占用扇区的第一个记录位置
+    struct SectorHead
+    {
+        uint32_t magic = SECTOR_MAGIC;
+        uint32_t seq = 0; // 扇区序号，每写一个新扇区加一，最大的为最新
+        uint16_t recordSize = sizeof(FlightRecord); // 记录格式变化时旧扇区视为无效
+        uint8_t reserved[20] = {};
+        uint16_t crc = 0; // 前30字节的CRC-16
+    }__attribute__((packed)); // 不进行字节对齐
+
+    static_assert(sizeof(SectorHead) == sizeof(FlightRecord), "sector head must fill one record slot");
+    static_assert(sizeof(FlightRecord) == 32, "flight record must be 32 bytes");
+    static_assert(FlightLog::PAGE_SIZE % sizeof(FlightRecord) == 0, "page must hold whole records");
+
+    bool headValid(const SectorHead& head) {
+        return head.magic == SECTOR_MAGIC && head.recordSize == sizeof(FlightRecord) &&
+               CRC16::calc(&head, offsetof(SectorHead, crc)) == head.crc;
+    }
+
+    bool recordValid(const FlightRecord& rec) {
+        return CRC16::calc(&rec, RECORD_CRC_LEN) == rec.crc;
+    }
+
+    void updateMax(std::atomic<uint32_t>& max, uint32_t value) {
+        if (value > max.load(std::memory_order_relaxed)) max.store(value, std::memory_order_relaxed);
+    }
+}
+
+FlightLog::FlightLog(const char* label) :
+    m_label(label),
+    m_part(nullptr),
+    m_sectors(0),
+    m_head(0),
+    m_tail(0),
+    m_writer(nullptr),
+    m_fill(0),
+    m_slot(0),
+    m_seq(1),
+    m_start(0),
+    m_entered(0),
+    m_erased_to(0),
+    m_records(0),
+    m_dropped(0),
+    m_written(0),
+    m_write_errors(0),
+    m_sync_erases(0),
+    m_backlog_max(0),
+    m_dump_comm(nullptr),
+    m_dumper(nullptr),
+    m_dumping(false) {
+}
+
+FlightLog::~FlightLog() {
+}
+
+/**
+ * @brief 找到分区并扫描各扇区头，从最新扇区之后的扇区继续写，预擦除最前面的扇区
+ *
+ * @return 分区存在且大小合适返回true
+ *
+ * @note 应在startWriter和push之前调用，扫描和预擦除耗时几十ms
+ */
+bool FlightLog::init() {
+    m_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, m_label);
+    if (!m_part) {
+        ESP_LOGE(TAG, "Partition %s not found !", m_label);
+        return false;
+    }
+
+    m_sectors = m_part->size / SECTOR_SIZE;
+    if (m_sectors < ERASE_AHEAD + 2) return false; // 至少保留一个有数据的扇区
+
+    bool found = false;
+    uint32_t newest = 0;
+    uint32_t maxSeq = 0;
+    for (uint32_t s = 0; s < m_sectors; s++) {
+        SectorHead head;
+        if (esp_partition_read(m_part, s * SECTOR_SIZE, &head, sizeof(head)) != ESP_OK) continue;
+        if (!headValid(head)) continue;
+        if (!found || head.seq > maxSeq) {
+            maxSeq = head.seq;
+            newest = s;
+            found = true;
+        }
+    }
+
+    m_start = found ? (newest + 1) % m_sectors : 0;
+    m_seq = found ? maxSeq + 1 : 1;
+
+    for (m_erased_to = 0; m_erased_to < ERASE_AHEAD; m_erased_to++) {
+        if (!_erase(m_erased_to)) return false;
+    }
+
+    ESP_LOGI(TAG, "%u sectors, resume at sector %u seq %u", (unsigned)m_sectors, (unsigned)m_start, (unsigned)m_seq);
+    return true;
+}
+
+/**
+ * @brief 启动写入任务
+ *
+ * @param priority 任务优先级，应低于采集和控制任务，擦除期间会占用flash数十ms
+ * @param core 绑定的核心
+ */
+bool FlightLog::startWriter(UBaseType_t priority, BaseType_t core) {
+    if (!m_part || m_writer.load(std::memory_order_relaxed)) return false;
+    return SYSMON::createTask(_writerTask, "flightLog", WRITER_STACK, this, priority, NULL, core);
+}
+
+/**
+ * @brief 把一条记录拷进页缓冲，填上CRC，写满一页时唤醒写入任务
+ *
+ * @return 页缓冲全满时丢弃记录并返回false
+ *
+ * @note 只允许一个任务调用，不访问flash，耗时为一次拷贝和30字节的CRC
+ */
+bool FlightLog::push(const FlightRecord& rec) {
+    if (!m_part) return false;
+
+    uint32_t head = m_head.load(std::memory_order_relaxed);
+    if (m_fill == 0 && head - m_tail.load(std::memory_order_acquire) >= PAGE_BUFS) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint8_t* page = m_pages[head % PAGE_BUFS];
+    if (m_slot == 0) { // 新扇区，第一个位置写扇区头
+        SectorHead sector;
+        sector.seq = m_seq;
+        sector.crc = CRC16::calc(&sector, offsetof(SectorHead, crc));
+        memcpy(page + m_fill, &sector, sizeof(sector));
+        m_fill += sizeof(sector);
+        m_slot++;
+    }
+
+    uint8_t* dst = page + m_fill;
+    memcpy(dst, &rec, RECORD_CRC_LEN);
+    uint16_t crc = CRC16::calc(dst, RECORD_CRC_LEN);
+    dst[RECORD_CRC_LEN] = crc & 0xFF; // 小端，与FlightRecord::crc相同
+    dst[RECORD_CRC_LEN + 1] = crc >> 8;
+    m_fill += RECORD_SIZE;
+    if (++m_slot == SLOTS) {
+        m_slot = 0;
+        m_seq++;
+    }
+    m_records.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_fill == PAGE_SIZE) { // 写满一页，交给写入任务
+        m_fill = 0;
+        m_head.store(head + 1, std::memory_order_release);
+        TaskHandle_t writer = m_writer.load(std::memory_order_acquire);
+        if (writer) xTaskNotifyGive(writer);
+    }
+    return true;
+}
+
+/**
+ * @brief 启动回放任务，任务平时阻塞，requestDump时从最旧的记录开始经COMM以LogChunk发出
+ *
+ * @param comm 发送使用的通讯对象
+ * @param priority 任务优先级，应为最低
+ * @param core 绑定的核心
+ *
+ * @note 任务在启动阶段创建并常驻，回放时不再创建任务和分配内存
+ */
+bool FlightLog::startDumper(COMM& comm, UBaseType_t priority, BaseType_t core) {
+    if (!m_part || m_dump_comm) return false;
+    m_dump_comm = &comm;
+    return SYSMON::createTask(_dumpTask, "logDump", DUMP_STACK, this, priority, NULL, core);
+}
+
+/**
+ * @brief 请求一次回放，写入照常进行
+ *
+ * @return 回放任务未就绪或已有回放在进行时返回false
+ */
+bool FlightLog::requestDump() {
+    TaskHandle_t dumper = m_dumper.load(std::memory_order_acquire);
+    if (!dumper || m_dumping.exchange(true)) return false;
+    xTaskNotifyGive(dumper);
+    return true;
+}
+
+FlightLogStats FlightLog::getStats() const {
+    FlightLogStats stats;
+    stats.records = m_records.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.pages = m_written.load(std::memory_order_relaxed);
+    stats.writeErrors = m_write_errors.load(std::memory_order_relaxed);
+    stats.erases = m_erase_hist.count();
+    stats.syncErases = m_sync_erases.load(std::memory_order_relaxed);
+    stats.backlogMax = m_backlog_max.load(std::memory_order_relaxed);
+    stats.writeP99 = m_write_hist.percentile(0.99f);
+    stats.writeMax = m_write_hist.max();
+    stats.eraseP99 = m_erase_hist.percentile(0.99f);
+    stats.eraseMax = m_erase_hist.max();
+    return stats;
+}
+
+/**
+ * @brief 分区保证能保存的记录数
+ * 
+ * @note 写入位置之后ERASE_AHEAD个扇区总是已擦除，重启后最新扇区的剩余位置被跳过，
+ *       这些扇区不计入；init成功前返回0
+ */
+size_t FlightLog::capacity() const {
+    if (m_sectors < ERASE_AHEAD + 2) return 0;
+    return (m_sectors - ERASE_AHEAD - 1) * (SLOTS - 1);
+}
+
+size_t FlightLog::_sectorAddr(uint32_t n) const {
+    return ((m_start + n) % m_sectors) * SECTOR_SIZE;
+}
+
+bool FlightLog::_erase(uint32_t n) {
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = esp_partition_erase_range(m_part, _sectorAddr(n), SECTOR_SIZE);
+    m_erase_hist.record(esp_timer_get_time() - t0);
+    if (err != ESP_OK) m_write_errors.fetch_add(1, std::memory_order_relaxed);
+    return err == ESP_OK;
+}
+
+/**
+ * @brief 写出一页，进入新扇区时该扇区应已被预擦除，否则先同步擦除
+ *
+ * @param page 本次开机写出的第几页
+ */
+void FlightLog::_writePage(uint32_t page) {
+    uint32_t n = page / PAGES_PER_SECTOR;
+    size_t offset = (page % PAGES_PER_SECTOR) * PAGE_SIZE;
+    if (offset == 0) {
+        if (m_erased_to <= n) {
+            m_sync_erases.fetch_add(1, std::memory_order_relaxed);
+            _erase(n);
+            m_erased_to = n + 1;
+        }
+        m_entered = n + 1;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = esp_partition_write(m_part, _sectorAddr(n) + offset, m_pages[page % PAGE_BUFS], PAGE_SIZE);
+    m_write_hist.record(esp_timer_get_time() - t0);
+    if (err != ESP_OK) m_write_errors.fetch_add(1, std::memory_order_relaxed);
+    m_written.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 写入任务：优先写出已满的页，空闲时每次擦除一个扇区，保持写入位置之后ERASE_AHEAD个扇区已擦除
+ */
+void FlightLog::_writerTask(void* arg) {
+    FlightLog& self = *static_cast<FlightLog*>(arg);
+    self.m_writer.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+
+    while (true) {
+        uint32_t tail = self.m_tail.load(std::memory_order_relaxed);
+        uint32_t head = self.m_head.load(std::memory_order_acquire);
+        if (tail != head) {
+            updateMax(self.m_backlog_max, head - tail);
+            self._writePage(tail);
+            self.m_tail.store(tail + 1, std::memory_order_release); // 归还页缓冲
+            continue;
+        }
+
+        if (self.m_erased_to < self.m_entered + ERASE_AHEAD) {
+            self._erase(self.m_erased_to);
+            self.m_erased_to++; // 擦除失败也前进，写入时会再计为错误
+            continue;
+        }
+
+        ulTaskNotifyTake(pdTRUE, WRITER_PERIOD);
+    }
+}
+
+/**
+ * @brief 从序号最小的扇区开始按环形顺序读出所有有效记录，打包发送
+ *
+ * @note 与写入并行进行：读到的扇区头在读完后被改写时丢弃该扇区余下的记录，
+ *       发送缓冲区满时等待而不是丢弃，回放速度受串口限制
+ */
+void FlightLog::_dump() {
+    COMM& comm = *m_dump_comm;
+    LogChunk chunk;
+    auto send = [&]() {
+        while (!comm.sendMsg(chunk)) vTaskDelay(1);
+        chunk.index += chunk.count;
+        chunk.count = 0;
+    };
+
+    bool found = false;
+    uint32_t oldest = 0;
+    uint32_t minSeq = 0;
+    for (uint32_t s = 0; s < m_sectors; s++) {
+        SectorHead head;
+        if (esp_partition_read(m_part, s * SECTOR_SIZE, &head, sizeof(head)) != ESP_OK || !headValid(head)) continue;
+        if (!found || head.seq < minSeq) {
+            minSeq = head.seq;
+            oldest = s;
+            found = true;
+        }
+    }
+
+    for (uint32_t k = 0; found && k < m_sectors; k++) {
+        size_t addr = ((oldest + k) % m_sectors) * SECTOR_SIZE;
+        SectorHead head;
+        if (esp_partition_read(m_part, addr, &head, sizeof(head)) != ESP_OK || !headValid(head)) continue;
+
+        for (size_t slot = 1; slot < SLOTS; slot += LogChunk::MAX_RECORDS) {
+            FlightRecord recs[LogChunk::MAX_RECORDS];
+            size_t n = SLOTS - slot < LogChunk::MAX_RECORDS ? SLOTS - slot : LogChunk::MAX_RECORDS;
+            if (esp_partition_read(m_part, addr + slot * RECORD_SIZE, recs, n * RECORD_SIZE) != ESP_OK) break;
+
+            SectorHead now;
+            if (esp_partition_read(m_part, addr, &now, sizeof(now)) != ESP_OK || now.seq != head.seq || !headValid(now)) break; // 已被擦除改写
+
+            for (size_t i = 0; i < n; i++) {
+                if (!recordValid(recs[i])) continue;
+                chunk.records[chunk.count++] = recs[i];
+                if (chunk.count == LogChunk::MAX_RECORDS) send();
+            }
+        }
+    }
+
+    chunk.done = 1;
+    send();
+}
+
+void FlightLog::_dumpTask(void* arg) {
+    FlightLog& self = *static_cast<FlightLog*>(arg);
+    self.m_dumper.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        self._dump();
+        ESP_LOGI(TAG, "Dump done !");
+        self.m_dumping.store(false);
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef FLIGHT_LOG_HPP
+#define FLIGHT_LOG_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_partition.h"
+#include "uart_data_pack.hpp"
+#include "histogram.hpp"
+
+class COMM;
+
+// 黑匣子统计，耗时单位为us
+struct FlightLogStats
+{
+    uint32_t records = 0; // 写入页缓冲的记录数
+    uint32_t dropped = 0; // 页缓冲全满丢弃的记录数
+    uint32_t pages = 0; // 写入flash的页数
+    uint32_t writeErrors = 0; // 写入或擦除失败次数
+    uint32_t erases = 0; // 擦除的扇区数
+    uint32_t syncErases = 0; // 预擦除没跟上、写入前临时擦除的次数
+    uint32_t backlogMax = 0; // 等待写入的页数最大值
+    uint32_t writeP99 = 0; // 单页写入耗时
+    uint32_t writeMax = 0;
+    uint32_t eraseP99 = 0; // 单扇区擦除耗时
+    uint32_t eraseMax = 0;
+};
+
+/**
+ * @brief 黑匣子，把定长记录循环写入专用的flash分区，不经过NVS和文件系统
+ *
+ * @param label 分区名，见partitions.csv
+ *
+ * @note 分区按4KB扇区循环使用，每个扇区首个记录位置为带递增序号的扇区头，最旧的扇区被依次擦除覆盖，
+ *       各扇区擦写次数相同。生产者只把记录拷进256字节的页缓冲，写满一页交给低优先级的写入任务整页写入；
+ *       写入任务空闲时提前擦除之后的扇区，写入路径上通常没有擦除。
+ *       页缓冲全满时丢弃新记录并计数，生产者从不等待flash。
+ *       但擦写flash期间两个核心的cache都被关闭，另一个核心上运行在flash中的代码（包括生产者）同样会停住，
+ *       单次擦除可达数十ms；sdkconfig.defaults开启了CONFIG_SPI_FLASH_AUTO_SUSPEND，flash芯片支持挂起时停顿只有几十us。
+ *       实际停顿用example/FlightLog_bench.cpp测量。
+ *       开机时从序号最大的扇区之后的扇区继续写，该扇区剩余的空间不再使用；掉电时丢失未写满一页的记录
+ */
+class FlightLog {
+    public:
+        static constexpr size_t SECTOR_SIZE = 4096; // 擦除单位
+        static constexpr size_t PAGE_SIZE = 256; // 写入单位，与flash页对齐
+        static constexpr size_t PAGE_BUFS = 8; // 页缓冲数，吸收一次擦除期间的记录，1kHz时约64ms
+        static constexpr size_t ERASE_AHEAD = 2; // 写入位置之后保持擦除的扇区数
+        static constexpr size_t RECORD_SIZE = sizeof(FlightRecord);
+        static constexpr size_t SLOTS = SECTOR_SIZE / RECORD_SIZE; // 每个扇区的记录位置数，含扇区头
+
+        FlightLog(const char* label = "flightlog");
+        ~FlightLog();
+
+        FlightLog(const FlightLog&) = delete;
+        FlightLog& operator=(const FlightLog&) = delete;
+
+        bool init(); // 找到分区，扫描扇区头确定写入位置并预擦除
+        bool startWriter(UBaseType_t priority, BaseType_t core = tskNO_AFFINITY); // 启动写入任务
+        bool push(const FlightRecord& rec); // 写入一条记录，只允许一个生产者，不阻塞
+        bool startDumper(COMM& comm, UBaseType_t priority, BaseType_t core = tskNO_AFFINITY); // 启动回放任务
+        bool requestDump(); // 请求一次回放，可在接收任务中调用
+        FlightLogStats getStats() const; // 统计
+        size_t capacity() const; // 分区保证能保存的记录数
+
+        static constexpr uint32_t WRITER_STACK = 3072; // 写入任务栈大小
+        static constexpr uint32_t DUMP_STACK = 4096; // 回放任务栈大小
+
+    private:
+
+        const char* m_label;
+        const esp_partition_t* m_part;
+        uint32_t m_sectors; // 分区扇区数
+
+        // 页缓冲环，生产者填写m_head所指的页，写入任务写出m_tail所指的页
+        uint8_t m_pages[PAGE_BUFS][PAGE_SIZE];
+        std::atomic<uint32_t> m_head; // 只由生产者写入
+        std::atomic<uint32_t> m_tail; // 只由写入任务写入
+        std::atomic<TaskHandle_t> m_writer; // 写入任务，写满一页时唤醒
+
+        // 以下只由生产者使用
+        size_t m_fill; // 当前页已填字节
+        uint32_t m_slot; // 下一条记录在扇区中的位置
+        uint32_t m_seq; // 当前扇区的序号
+
+        // 以下只由写入任务使用，扇区按自m_start起的个数计
+        uint32_t m_start; // 本次开机写入的第一个扇区
+        uint32_t m_entered; // 已开始写入的扇区数
+        uint32_t m_erased_to; // 已擦除的扇区数
+        LatencyHist m_write_hist; // 单页写入耗时
+        LatencyHist m_erase_hist; // 单扇区擦除耗时
+
+        std::atomic<uint32_t> m_records;
+        std::atomic<uint32_t> m_dropped;
+        std::atomic<uint32_t> m_written; // 写入的页数
+        std::atomic<uint32_t> m_write_errors;
+        std::atomic<uint32_t> m_sync_erases;
+        std::atomic<uint32_t> m_backlog_max;
+
+        COMM* m_dump_comm; // 回放使用的通讯对象
+        std::atomic<TaskHandle_t> m_dumper; // 回放任务
+        std::atomic<bool> m_dumping; // 回放进行中
+
+        size_t _sectorAddr(uint32_t n) const; // 本次开机第n个扇区的地址
+        bool _erase(uint32_t n); // 擦除本次开机第n个扇区
+        void _writePage(uint32_t page); // 写出一页，必要时先擦除
+        void _dump(); // 回放全部记录
+        static void _writerTask(void* arg); // 写入任务
+        static void _dumpTask(void* arg); // 回放任务
+};
+
+#endif
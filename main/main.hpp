@@ -5,15 +5,25 @@
 #include "uart.hpp"
 #include "system.hpp"
 #include "adc.hpp"
+#include "adc_meter.hpp"
 #include "mpu9250.hpp"
 #include "icm20948.hpp"
 #include "flash.hpp"
+#include "param_store.hpp"
 #include "ahrs.hpp"
 #include "datapack.hpp"
+#include "trace.hpp"
+#include "cmd_mailbox.hpp"
+#include "pipeline.hpp"
+#include "flight_log.hpp"
+#include "probe.hpp"
+#include "sysmon.hpp"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h" 
+#include "freertos/semphr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include <cstdio>
 #include <cmath>
@@ -0,0 +1,318 @@
+#include "pipeline.hpp"
+#include <cmath>
+#include "trace.hpp"
+#include "probe.hpp"
+#include "system.hpp"
+#include "interp.hpp"
+#include "esp_timer.h"
+#include "esp_attr.h"
+
+bool startStage(const StageConfig& cfg, TaskFunction_t fn, void* arg, TaskHandle_t* handle) {
+    return SYSMON::createTask(fn, cfg.name, cfg.stack, arg, cfg.priority, handle, cfg.core);
+}
+
+namespace {
+    // periods个采样周期对应的节拍数，向上取整，至少一个节拍
+    TickType_t periodTicks(float hz, float periods) {
+        TickType_t ticks = (TickType_t)ceilf(periods * configTICK_RATE_HZ / hz);
+        return ticks ? ticks : 1;
+    }
+}
+
+Pipeline::Pipeline(ReadFn read, AHRS& ahrs, COMM& comm, MagFn readMag) :
+    m_read(read),
+    m_read_mag(readMag),
+    m_ahrs(ahrs),
+    m_comm(comm),
+    m_started(false),
+    m_read_errors(0),
+    m_mag_div(1),
+    m_mag_cnt(0),
+    m_use_drdy(false),
+    m_drdy_stamp(0),
+    m_drdy_count(0),
+    m_acq_task(nullptr),
+    m_drdy_missed(0),
+    m_drdy_timeouts(0),
+    m_send_failed(0),
+    m_log(nullptr),
+    m_status(nullptr) {
+}
+
+Pipeline::~Pipeline() {
+}
+
+/**
+ * @brief 按下游到上游的顺序启动各阶段，采集开始时消费者已就绪
+ *
+ * @param cfg 流水线参数
+ *
+ * @return 全部启动成功返回true，只能启动一次
+ */
+bool Pipeline::start(const PipelineConfig& cfg) {
+    if (m_started) return false;
+    m_cfg = cfg;
+    m_started = true;
+
+    m_mag_div = m_cfg.magHz ? m_cfg.hz / m_cfg.magHz : 0;
+    if (m_mag_div < 1) m_mag_div = 1;
+    if (!m_use_drdy) m_rate.emplace(m_cfg.hz, RATE_SKIP); // 超时时保持采样相位
+
+    return startStage(m_cfg.comm, _commTask, this) &&
+           startStage(m_cfg.fusion, _fusionTask, this) &&
+           startStage(m_cfg.acq, _acqTask, this);
+}
+
+/**
+ * @brief 由传感器的数据就绪中断驱动采集，以中断时刻作为采样时间戳
+ *
+ * @param pin 接传感器INT引脚的输入，需已按上升沿中断初始化，传感器侧需使能数据就绪输出
+ *
+ * @return 注册中断成功返回true
+ *
+ * @note 采集频率由传感器决定，cfg.hz应设为传感器输出频率；超过DRDY_TIMEOUT_PERIODS个周期没有中断（引脚未接）时
+ *       退回按cfg.hz读取，受FreeRTOS节拍限制取整到节拍
+ */
+bool Pipeline::setDataReady(GPIO& pin) {
+    if (m_started) return false;
+    m_use_drdy = pin.addIsr(_onDataReady, this);
+    return m_use_drdy;
+}
+
+/**
+ * @brief 融合阶段按cfg.logHz把采样和姿态写入黑匣子
+ *
+ * @param log 已init的黑匣子，写入任务应已启动
+ *
+ * @return 在start之前调用返回true
+ */
+bool Pipeline::setLogger(FlightLog& log) {
+    if (m_started) return false;
+    m_log = &log;
+    return true;
+}
+
+bool Pipeline::setStatus(StatusFn fn) {
+    if (m_started) return false;
+    m_status = fn;
+    return true;
+}
+
+/**
+ * @brief 写一条黑匣子记录，角速度按1/16°/s量化，超出int16时截断
+ */
+void Pipeline::_logSample(const ImuSample& sample, const AttiSample& atti) {
+    auto clamp16 = [](double value) -> int16_t {
+        if (value > INT16_MAX) return INT16_MAX;
+        if (value < INT16_MIN) return INT16_MIN;
+        return (int16_t)value;
+    };
+
+    FlightRecord rec;
+    rec.stamp = (uint32_t)sample.stamp;
+    rec.atti[0] = atti.atti.x;
+    rec.atti[1] = atti.atti.y;
+    rec.atti[2] = atti.atti.z;
+    rec.gyro[0] = clamp16(sample.gyro.x * 16);
+    rec.gyro[1] = clamp16(sample.gyro.y * 16);
+    rec.gyro[2] = clamp16(sample.gyro.z * 16);
+    rec.accel[0] = clamp16(sample.accel.x);
+    rec.accel[1] = clamp16(sample.accel.y);
+    rec.accel[2] = clamp16(sample.accel.z);
+    rec.flags = (atti.still ? LOG_STILL : 0) | (atti.magValid ? LOG_MAG_VALID : 0);
+    m_log->push(rec); // 页缓冲满时丢弃，由黑匣子计数
+}
+
+/**
+ * @brief 数据就绪中断，只记录时刻并唤醒采集任务
+ *
+ * @note 以ESP_INTR_FLAG_IRAM注册，flash擦写期间也会执行，只能调用IRAM中的函数；
+ *       只用32位原子读写，在Xtensa上为内联指令，64位原子会调用库函数
+ */
+void IRAM_ATTR Pipeline::_onDataReady(void* arg) {
+    Pipeline& self = *static_cast<Pipeline*>(arg);
+    self.m_drdy_stamp.store((uint32_t)esp_timer_get_time(), std::memory_order_relaxed);
+    self.m_drdy_count.store(self.m_drdy_count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    TaskHandle_t task = self.m_acq_task.load(std::memory_order_acquire);
+    if (!task) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * @brief 读取最新姿态，不阻塞
+ *
+ * @return 版本号，每次融合加一，0表示尚无姿态或与发布重叠未读到，out不变
+ */
+uint32_t Pipeline::latest(AttiSample& out) const {
+    return m_latest.read(out);
+}
+
+PipelineStats Pipeline::getStats() const {
+    PipelineStats stats;
+    stats.readErrors = m_read_errors;
+    stats.imuDropped = m_imu.dropped();
+    stats.attiDropped = m_atti.dropped();
+    stats.sendFailed = m_send_failed;
+    stats.drdyMissed = m_drdy_missed;
+    stats.drdyTimeouts = m_drdy_timeouts;
+
+    if (m_rate) stats.acq = m_rate->getStats();
+    return stats;
+}
+
+/**
+ * @brief 读取一次IMU，按分频附带磁力计，交给融合阶段，只由采集任务调用
+ *
+ * @param stamp 采样时刻
+ */
+void Pipeline::_acquire(int64_t stamp) {
+    ImuSample sample;
+    sample.stamp = stamp;
+    if (!m_read(sample.gyro, sample.accel)) {
+        m_read_errors++;
+        return;
+    }
+
+    if (m_read_mag && ++m_mag_cnt >= m_mag_div) {
+        m_mag_cnt = 0;
+        int64_t now = esp_timer_get_time();
+        if (m_read_mag(sample.mag)) sample.magStamp = now;
+    }
+    m_imu.push(sample);
+}
+
+/**
+ * @brief 采集阶段：只做I2C读取。有数据就绪中断时每次中断读取一次，以中断时刻为时间戳；
+ *        否则按固定频率读取，以读取开始时刻为时间戳
+ */
+void Pipeline::_acqTask(void* arg) {
+    Pipeline& self = *static_cast<Pipeline*>(arg);
+    self.m_acq_task.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+
+    if (self.m_use_drdy) {
+        const TickType_t timeout = periodTicks(self.m_cfg.hz, DRDY_TIMEOUT_PERIODS);
+        const TickType_t period = periodTicks(self.m_cfg.hz, 1.0f);
+        TickType_t wait = timeout;
+        uint32_t lastCount = self.m_drdy_count.load(std::memory_order_acquire);
+        uint32_t lastStamp = self.m_drdy_stamp.load(std::memory_order_relaxed);
+        while (true) {
+            if (!ulTaskNotifyTake(pdTRUE, wait)) {
+                self.m_drdy_timeouts++;
+                self._acquire(esp_timer_get_time());
+                wait = period; // 中断恢复前按采样周期读取
+                continue;
+            }
+            wait = timeout;
+
+            uint32_t count = self.m_drdy_count.load(std::memory_order_acquire);
+            uint32_t stamp = self.m_drdy_stamp.load(std::memory_order_relaxed); // 不早于count对应的中断
+            if (count == lastCount) continue; // 已在上次唤醒中处理
+            if (stamp == lastStamp) { // 上次读取时已取到这次中断的时刻和数据
+                lastCount = count;
+                continue;
+            }
+            self.m_drdy_missed += count - lastCount - 1; // 读取期间又来了中断，寄存器中只有最新一组
+            lastCount = count;
+            lastStamp = stamp;
+
+            int64_t now = esp_timer_get_time();
+            self._acquire(now - (uint32_t)((uint32_t)now - stamp)); // 补回高位，中断到读取远短于32位us的回绕周期
+        }
+    }
+
+    while (true) {
+        self._acquire(esp_timer_get_time());
+        self.m_rate->sleep(); // 控制循环频率
+    }
+}
+
+/**
+ * @brief 融合阶段：每个采样到达即按与上一采样的时间戳之差积分，对齐磁力计，发布最新值并交给通讯阶段
+ */
+void Pipeline::_fusionTask(void* arg) {
+    Pipeline& self = *static_cast<Pipeline*>(arg);
+    const float nominalDt = 1.0f / self.m_cfg.hz;
+    Vec3Interp mag(MAG_MAX_AGE_US);
+    int64_t last = 0;
+    bool first = true;
+    uint32_t logDiv = self.m_cfg.logHz ? self.m_cfg.hz / self.m_cfg.logHz : 0;
+    if (logDiv < 1) logDiv = 1;
+    uint32_t logCnt = 0;
+
+    while (true) {
+        ImuSample sample;
+        self.m_imu.pop(sample);
+
+        // 首个采样和时间戳异常时用标称dt，采集停顿后限制单步积分
+        float dt = nominalDt;
+        int64_t elapsed = sample.stamp - last;
+        if (last && elapsed > 0) dt = (elapsed < MAX_DT_US ? elapsed : MAX_DT_US) * 1e-6f;
+        last = sample.stamp;
+
+        AttiSample out;
+        out.stamp = sample.stamp;
+        {
+            PROBE_SCOPE(AHRS_EST);
+            out.atti = self.m_ahrs.attiEst(sample.gyro, sample.accel, dt, AHRS_MODE::CF{});
+        }
+        out.gyroBias = self.m_ahrs.getGyroBias();
+        out.still = self.m_ahrs.isStill();
+
+        if (sample.magStamp) mag.push(sample.magStamp, sample.mag);
+        out.magValid = mag.at(sample.stamp, out.mag);
+
+        if (first) { // 上电到首个有效姿态的耗时
+            TRACE(BOOT_FIRST_ATTI, (uint32_t)esp_timer_get_time());
+            first = false;
+        }
+
+        self.m_latest.write(out);
+        self.m_atti.push(out);
+
+        if (self.m_log && self.m_cfg.logHz && ++logCnt >= logDiv) {
+            logCnt = 0;
+            self._logSample(sample, out);
+        }
+    }
+}
+
+/**
+ * @brief 通讯阶段：按反馈频率抽取姿态，写二进制日志并发送反馈，周期发送耗时探针统计
+ *
+ * @note 发送任务未启动时uartSendPack会阻塞在串口上，只影响本阶段，积压的姿态由队列吸收
+ */
+void Pipeline::_commTask(void* arg) {
+    Pipeline& self = *static_cast<Pipeline*>(arg);
+    uint32_t div = self.m_cfg.feedbackHz ? self.m_cfg.hz / self.m_cfg.feedbackHz : 0;
+    if (div < 1) div = 1;
+    uint32_t cnt = 0;
+    int64_t lastProbe = esp_timer_get_time();
+
+    while (true) {
+        AttiSample atti;
+        self.m_atti.pop(atti);
+
+        if (self.m_cfg.probePeriodMs && atti.stamp - lastProbe >= self.m_cfg.probePeriodMs * 1000LL) {
+            ProbeReport report = PROBE::report();
+            if (report.count) self.m_comm.sendMsg(report);
+            lastProbe = atti.stamp;
+        }
+
+        if (!self.m_cfg.feedbackHz || ++cnt < div) continue;
+        cnt = 0;
+
+        TRACE(ATTI, atti.atti.x, atti.atti.y, atti.atti.z);
+        TRACE(GYRO_BIAS, atti.gyroBias.x, atti.gyroBias.y, atti.gyroBias.z, atti.still);
+
+        RoBoFeedBack feedback;
+        feedback.roll = atti.atti.x;
+        feedback.pitch = atti.atti.y;
+        feedback.yaw = atti.atti.z;
+        if (self.m_status) feedback.status = self.m_status();
+        PROBE_SCOPE(FEEDBACK_SEND);
+        if (!self.m_comm.uartSendPack(feedback)) self.m_send_failed++;
+    }
+}
@@ -0,0 +1,171 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <atomic>
+#include <optional>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "struct.hpp"
+#include "spsc_queue.hpp"
+#include "mailbox.hpp"
+#include "ahrs.hpp"
+#include "datapack.hpp"
+#include "system.hpp"
+#include "gpio.hpp"
+#include "sysmon.hpp"
+#include "flight_log.hpp"
+
+// 一个流水线阶段的任务参数
+struct StageConfig
+{
+    const char* name;
+    uint32_t stack; // 栈大小（字节）
+    UBaseType_t priority; // 任务优先级
+    BaseType_t core; // 绑定的核心，tskNO_AFFINITY为不绑定
+};
+
+/**
+ * @brief 流水线阶段之间的连接，预分配的单生产者单消费者队列，压入时唤醒消费者
+ *
+ * @param T 记录类型
+ * @param N 容量，必须是2的幂
+ *
+ * @note 生产者从不等待，队列满时丢弃新记录并计数；消费者在队列空时用任务通知阻塞，
+ *       首次pop时登记消费者任务，因此消费者任务的通知值（索引0）归该连接使用
+ */
+template <class T, size_t N>
+class StageLink {
+    public:
+        // 生产者：压入一个记录并唤醒消费者，队列满时返回false
+        bool push(const T& value) {
+            if (!m_queue.push(value)) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            TaskHandle_t consumer = m_consumer.load(std::memory_order_acquire);
+            if (consumer) xTaskNotifyGive(consumer);
+            return true;
+        }
+
+        // 消费者：取出一个记录，队列空时最多等待wait，超时返回false
+        bool pop(T& value, TickType_t wait = portMAX_DELAY) {
+            if (!m_consumer.load(std::memory_order_relaxed))
+                m_consumer.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+
+            // 登记之后的压入都会通知，登记之前的压入已在队列中，不会漏掉唤醒
+            while (!m_queue.pop(value)) {
+                if (!ulTaskNotifyTake(pdTRUE, wait)) return false;
+            }
+            return true;
+        }
+
+        size_t size() const { return m_queue.size(); }
+        uint32_t dropped() const { return m_dropped.load(std::memory_order_relaxed); } // 队列满丢弃的记录数
+
+    private:
+        SpscQueue<T, N> m_queue;
+        std::atomic<TaskHandle_t> m_consumer{nullptr}; // 消费者任务
+        std::atomic<uint32_t> m_dropped{0};
+};
+
+/**
+ * @brief 启动一个流水线阶段任务，绑定到cfg.core，经SYSMON创建以便报告栈水位
+ *
+ * @return 创建成功返回true
+ */
+bool startStage(const StageConfig& cfg, TaskFunction_t fn, void* arg, TaskHandle_t* handle = NULL);
+
+// 流水线参数，采集和融合独占一个核心，通讯与串口驱动同在另一个核心
+struct PipelineConfig
+{
+    float hz = 1000; // 采样频率，使用数据就绪中断时应设为传感器输出频率，用作标称dt
+    uint32_t magHz = 100; // 磁力计读取频率，不超过其测量频率
+    uint32_t feedbackHz = 100; // 反馈和日志频率
+    uint32_t probePeriodMs = 1000; // 耗时探针统计的发送周期，0为不发送
+    uint32_t logHz = 200; // 黑匣子记录频率，需先setLogger
+    StageConfig acq = {"acq", 3072, 6, 1}; // 采集：I2C读取，命令链在栈上
+    StageConfig fusion = {"fusion", 3072, 5, 1}; // 融合：姿态估计
+    StageConfig comm = {"pipeComm", 4096, 3, 0}; // 通讯：反馈、日志和探针统计
+};
+
+// 流水线统计
+struct PipelineStats
+{
+    uint32_t readErrors = 0; // IMU读取失败次数
+    uint32_t imuDropped = 0; // 融合阶段跟不上丢弃的采样数
+    uint32_t attiDropped = 0; // 通讯阶段跟不上丢弃的姿态数
+    uint32_t sendFailed = 0; // 发送缓冲区满未能发出的反馈数
+    uint32_t drdyMissed = 0; // 采集来不及读取而被覆盖的数据就绪中断数
+    uint32_t drdyTimeouts = 0; // 等待数据就绪中断超时、按周期读取的次数
+    RateStats acq; // 采集周期和唤醒抖动
+};
+
+/**
+ * @brief IMU流水线：采集 -> 融合 -> 通讯，各阶段为独立的绑核任务，经预分配的队列传递记录
+ *
+ * @param read IMU读取函数，输出陀螺仪（°/s）和加速度计（原始值）
+ * @param ahrs 姿态估计器，只由融合阶段使用
+ * @param comm 通讯对象，只由通讯阶段使用，发送任务应先启动以免阻塞
+ * @param readMag 磁力计读取函数，可为空
+ *
+ * @note 采集和融合不等待串口：通讯阶段阻塞时姿态在队列中堆积，满了丢弃最新记录并计数，
+ *       控制任务可用latest无锁读取最新姿态而不经过通讯阶段。
+ *       每个采样带采集时刻的时间戳，融合阶段按相邻时间戳计算实际dt，磁力计按时间戳插值对齐到每个采样
+ */
+class Pipeline {
+    public:
+        using ReadFn = bool (*)(Vec3lf& gyro, Vec3lf& accel);
+        using MagFn = bool (*)(Vec3lf& mag);
+        using StatusFn = uint8_t (*)(); // 反馈包status字段的来源，在通讯阶段调用，不应阻塞
+
+        Pipeline(ReadFn read, AHRS& ahrs, COMM& comm, MagFn readMag = nullptr);
+        ~Pipeline();
+
+        bool setDataReady(GPIO& pin); // 由传感器数据就绪中断驱动采集，需在start之前调用
+        bool setLogger(FlightLog& log); // 融合阶段把采样和姿态写入黑匣子，需在start之前调用
+        bool setStatus(StatusFn fn); // 每个反馈包的status由fn给出，需在start之前调用
+        bool start(const PipelineConfig& cfg = PipelineConfig()); // 启动三个阶段任务
+        uint32_t latest(AttiSample& out) const; // 最新姿态
+        PipelineStats getStats() const; // 统计
+    private:
+        static constexpr size_t IMU_QUEUE = 16; // 采集到融合的队列长度
+        static constexpr size_t ATTI_QUEUE = 64; // 融合到通讯的队列长度，容纳串口的短时阻塞
+        static constexpr float DRDY_TIMEOUT_PERIODS = 2.0f; // 等待数据就绪中断的超时（采样周期数），超时后按周期读取
+        static constexpr int64_t MAX_DT_US = 50000; // 相邻采样的最大积分间隔，采集停顿时防止一步积分过大
+        static constexpr int64_t MAG_MAX_AGE_US = 100000; // 磁力计超过该时间未更新视为失效
+
+        ReadFn m_read;
+        MagFn m_read_mag;
+        AHRS& m_ahrs;
+        COMM& m_comm;
+        PipelineConfig m_cfg;
+        bool m_started;
+
+        StageLink<ImuSample, IMU_QUEUE> m_imu; // 采集 -> 融合
+        StageLink<AttiSample, ATTI_QUEUE> m_atti; // 融合 -> 通讯
+        Mailbox<AttiSample> m_latest; // 最新姿态
+        std::optional<Rate> m_rate; // 定时采集的频率控制，在start中构造，采集任务不再分配定时器
+        uint32_t m_read_errors; // 只由采集阶段写入
+        uint32_t m_mag_div; // 每多少个采样读取一次磁力计
+        uint32_t m_mag_cnt;
+
+        bool m_use_drdy; // 由数据就绪中断驱动采集
+        std::atomic<uint32_t> m_drdy_stamp; // 最近一次数据就绪中断时刻（us）的低32位，只由中断写入
+        std::atomic<uint32_t> m_drdy_count; // 数据就绪中断次数，只由中断写入
+        std::atomic<TaskHandle_t> m_acq_task; // 采集任务，中断据此唤醒
+        uint32_t m_drdy_missed;
+        uint32_t m_drdy_timeouts;
+        uint32_t m_send_failed; // 只由通讯阶段写入
+        FlightLog* m_log; // 黑匣子，只由融合阶段写入
+        StatusFn m_status; // 只由通讯阶段调用
+
+        void _logSample(const ImuSample& sample, const AttiSample& atti); // 写一条黑匣子记录
+
+        void _acquire(int64_t stamp); // 读取一次IMU并交给融合阶段
+        static void _onDataReady(void* arg); // 数据就绪中断
+        static void _acqTask(void* arg); // 采集阶段
+        static void _fusionTask(void* arg); // 融合阶段
+        static void _commTask(void* arg); // 通讯阶段
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "probe.hpp"
+#include "histogram.hpp"
+#include "esp_attr.h"
+#include "esp_rom_sys.h"
+
+static_assert(PROBE_ID_NUM <= ProbeReport::MAX_PROBES, "too many probes for one ProbeReport");
+
+#if PROBE_ENABLE
+namespace {
+    // 每个核心一组直方图，同一核心上的记录者在关中断期间写入，彼此不会交错
+    LatencyHist hists[portNUM_PROCESSORS][PROBE_ID_NUM];
+}
+
+/**
+ * @brief 记录一次耗时，由Scope析构时调用
+ * 
+ * @param id 探针ID
+ * @param core 开始计时的核心
+ * @param cycles 耗时（CPU周期）
+ */
+void IRAM_ATTR PROBE::record(uint8_t id, uint8_t core, uint32_t cycles) {
+    if (id >= PROBE_ID_NUM) return;
+
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+    if (xPortGetCoreID() == core) hists[core][id].record(cycles); // 中途迁移时两个计数器不可比
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+/**
+ * @brief 合并各核心的直方图生成诊断消息，只包含有记录的探针
+ * 
+ * @note 读取另一核心的直方图时不加锁，统计可能相差一次记录
+ */
+ProbeReport PROBE::report() {
+    ProbeReport rep;
+    rep.cpuHz = esp_rom_get_cpu_ticks_per_us() * 1000000;
+
+    for (uint8_t id = 0; id < PROBE_ID_NUM; id++) {
+        LatencyHist sum;
+        for (int core = 0; core < portNUM_PROCESSORS; core++) sum.merge(hists[core][id]);
+        if (!sum.count()) continue;
+
+        ProbeStat& stat = rep.probes[rep.count++];
+        stat.id = id;
+        stat.count = sum.count();
+        stat.min = sum.min();
+        stat.p50 = sum.percentile(0.5f);
+        stat.p99 = sum.percentile(0.99f);
+        stat.max = sum.max();
+    }
+    return rep;
+}
+
+/**
+ * @brief 清空所有直方图，应在被测代码空闲时调用，否则可能残留一次记录
+ */
+void PROBE::reset() {
+    for (auto& core : hists)
+        for (LatencyHist& hist : core) hist.reset();
+}
+#else
+void PROBE::record(uint8_t, uint8_t, uint32_t) {}
+ProbeReport PROBE::report() { return ProbeReport(); }
+void PROBE::reset() {}
+#endif
@@ -0,0 +1,51 @@
+#ifndef PROBE_HPP
+#define PROBE_HPP
+
+#include <cstdint>
+#include "esp_cpu.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "uart_data_pack.hpp"
+#include "probe_ids.hpp"
+
+/**
+ * 耗时探针，统计代码段的CPU周期分布
+ * 每个探针每个核心一个对数-线性直方图，作用域结束时关中断记录，只有几十个周期；
+ * 周期计数器各核心独立，任务在作用域中途迁移到另一核心时丢弃该次记录
+ * 
+ * 用法：{ PROBE_SCOPE(AHRS_EST); ahrs.attiEst(...); }  ID在probe_ids.hpp中定义
+ * 编译时定义 PROBE_ENABLE=0 可以完全去掉所有探针和直方图
+ */
+#ifndef PROBE_ENABLE
+#define PROBE_ENABLE 1
+#endif
+
+namespace PROBE {
+    void record(uint8_t id, uint8_t core, uint32_t cycles); // 记录一次耗时
+    ProbeReport report(); // 合并各核心的直方图，生成可直接sendMsg的诊断消息
+    void reset(); // 清空所有直方图
+
+    // 作用域计时器，构造时读取周期计数，析构时记录
+    class Scope {
+        public:
+            explicit Scope(uint8_t id) : m_id(id), m_core(xPortGetCoreID()), m_start(esp_cpu_get_cycle_count()) {}
+            ~Scope() { record(m_id, m_core, esp_cpu_get_cycle_count() - m_start); }
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+        private:
+            uint8_t m_id;
+            uint8_t m_core;
+            uint32_t m_start;
+    };
+}
+
+#define PROBE_CAT_(a, b) a##b
+#define PROBE_CAT(a, b) PROBE_CAT_(a, b)
+
+#if PROBE_ENABLE
+#define PROBE_SCOPE(name) PROBE::Scope PROBE_CAT(_probe_, __LINE__)(PROBE_##name)
+#else
+#define PROBE_SCOPE(name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef PROBE_IDS_HPP
+#define PROBE_IDS_HPP
+
+#include <cstdint>
+
+/**
+ * 耗时探针的ID和说明，ID按列表顺序从0分配，上位机 tools/trace_fmt.py 解析本文件显示探针名
+ * 新增条目只能追加在末尾
+ */
+#define PROBE_LIST(X) \
+    X(GYRO_READ,        "ICM20948::readGyro") \
+    X(ACCEL_READ,       "ICM20948::readAccel") \
+    X(AHRS_EST,         "AHRS::attiEst") \
+    X(FEEDBACK_SEND,    "COMM::uartSendPack")
+
+#define PROBE_ENUM(name, desc) PROBE_##name,
+enum PROBE_ID : uint8_t {
+    PROBE_LIST(PROBE_ENUM)
+    PROBE_ID_NUM
+};
+#undef PROBE_ENUM
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include "uart_data_pack.hpp"
+#include "crc16.hpp"
+#include "cobs.hpp"
+
+/**
+ * 帧格式，编译期选择：
+ * COMM_FRAMING_HEADER - | 0x55 | 0xAA | ID | LEN | 负载 | CRC |，见uart_data_pack.hpp
+ * COMM_FRAMING_COBS   - COBS( ID | LEN | 负载 | CRC ) 0x00，CRC与帧头格式相同（包含0x55 0xAA）
+ *                       负载中的0x55 0xAA不会被误认为帧头，线路噪声后在下一个0x00处立即重新同步，
+ *                       代价是每帧多1字节，负载不超过249字节
+ */
+#define COMM_FRAMING_HEADER 0
+#define COMM_FRAMING_COBS 1
+#ifndef COMM_FRAMING
+#define COMM_FRAMING COMM_FRAMING_HEADER
+#endif
+
+/**
+ * @brief 消息注册表，列出一条链路上使用的所有消息结构体
+ *
+ * @note 每个消息结构体需为packed，并带有 static constexpr uint8_t ID
+ *       变长消息额外提供 size_t size() const，返回实际需要发送的字节数
+ */
+template <class... Msgs>
+struct MsgList {};
+
+namespace PROTOCOL {
+    constexpr size_t HEAD_LEN = sizeof(FrameHead); // 帧头长度
+    constexpr size_t CRC_LEN = 2; // 校验和长度
+    constexpr size_t OVERHEAD = HEAD_LEN + CRC_LEN; // 帧固定开销
+    constexpr size_t MAX_PAYLOAD = 255; // 负载最大长度
+    constexpr size_t MAX_FRAME = OVERHEAD + MAX_PAYLOAD; // 帧最大长度
+
+    constexpr size_t COBS_OVERHEAD = 2; // COBS帧在去掉0x55 0xAA后多出的起始码字节和分隔符
+    constexpr size_t COBS_MAX_PAYLOAD = COBS::MAX_BLOCK - 1 - (HEAD_LEN - 2) - CRC_LEN; // 保证帧体为单块编码
+    constexpr size_t WIRE_OVERHEAD = COMM_FRAMING == COMM_FRAMING_COBS ? OVERHEAD - 2 + COBS_OVERHEAD : OVERHEAD; // 线路上每帧的固定开销
+
+    // 检查消息是否为变长消息
+    template <class T, class = void>
+    struct HasSize : std::false_type {};
+    template <class T>
+    struct HasSize<T, std::void_t<decltype(std::declval<const T&>().size())>> : std::true_type {};
+
+    // 消息实际的负载长度，变长消息只发送有效部分
+    template <class T>
+    size_t msgSize(const T& msg) {
+        if constexpr (HasSize<T>::value) return msg.size();
+        else return sizeof(T);
+    }
+
+    // 检查消息是否走可靠通道，可靠消息声明 static constexpr bool RELIABLE = true 并带 uint16_t seq
+    template <class T, class = void>
+    struct IsReliable : std::false_type {};
+    template <class T>
+    struct IsReliable<T, std::void_t<decltype(T::RELIABLE)>> : std::integral_constant<bool, T::RELIABLE> {};
+
+    // 可靠序号在负载中的偏移，非可靠消息返回-1
+    template <class T>
+    constexpr int seqOffset() {
+        if constexpr (IsReliable<T>::value) return offsetof(T, seq);
+        else return -1;
+    }
+
+    // 从负载中读取可靠序号，负载太短（旧版发送端）时视为普通消息返回0
+    inline uint16_t readSeq(const uint8_t* payload, size_t len, int offset) {
+        if (offset < 0 || len < (size_t)offset + 2) return 0;
+        return payload[offset] | (payload[offset + 1] << 8);
+    }
+
+    // 编译期检查ID不重复
+    template <class... Msgs>
+    constexpr bool uniqueId() {
+        constexpr uint8_t ids[] = {Msgs::ID...};
+        for (size_t i = 0; i < sizeof...(Msgs); i++)
+            for (size_t j = i + 1; j < sizeof...(Msgs); j++)
+                if (ids[i] == ids[j]) return false;
+        return true;
+    }
+
+    /**
+     * @brief 把一个消息编码成完整的帧
+     *
+     * @param msg 消息
+     * @param buf 输出缓冲区，至少 OVERHEAD + msgSize(msg) 字节
+     *
+     * @return 帧长度
+     */
+    template <class T>
+    size_t encode(const T& msg, uint8_t* buf) {
+        static_assert(std::is_trivially_copyable<T>::value, "message must be trivially copyable");
+        static_assert(sizeof(T) <= MAX_PAYLOAD, "message too long");
+
+        size_t len = msgSize(msg);
+        FrameHead head;
+        head.id = T::ID;
+        head.len = len;
+        memcpy(buf, &head, HEAD_LEN);
+        memcpy(buf + HEAD_LEN, &msg, len);
+
+        uint16_t crc = CRC16::calc(buf, HEAD_LEN + len);
+        buf[HEAD_LEN + len] = crc & 0xFF;
+        buf[HEAD_LEN + len + 1] = crc >> 8;
+        return OVERHEAD + len;
+    }
+
+    /**
+     * @brief 按编译期选择的帧格式编码一帧
+     *
+     * @param msg 消息
+     * @param buf 输出缓冲区，至少 WIRE_OVERHEAD + msgSize(msg) 字节
+     *
+     * @return 线路上的帧长度，恒为 WIRE_OVERHEAD + msgSize(msg)
+     */
+    template <class T>
+    size_t encodeWire(const T& msg, uint8_t* buf) {
+#if COMM_FRAMING == COMM_FRAMING_COBS
+        static_assert(sizeof(T) <= COBS_MAX_PAYLOAD, "message too long for COBS framing");
+
+        // 帧体从buf[1]开始，与帧头格式的帧去掉0x55 0xAA相同，buf[0]留给COBS起始码字节
+        static const uint8_t header[2] = {HEADER_1, HEADER_2};
+        size_t len = msgSize(msg);
+        uint8_t* body = buf + 1;
+        body[0] = T::ID;
+        body[1] = len;
+        memcpy(body + 2, &msg, len);
+
+        uint16_t crc = CRC16::update(CRC16::update(CRC16::INIT, header, 2), body, 2 + len);
+        body[2 + len] = crc & 0xFF;
+        body[3 + len] = crc >> 8;
+        return COBS::encode(buf, len + 4);
+#else
+        return encode(msg, buf);
+#endif
+    }
+
+    /**
+     * @brief 把负载解码为消息结构体，长度不符时按较短的一方拷贝，其余字段保持默认值
+     */
+    template <class T>
+    void decode(const uint8_t* payload, size_t len, T& msg) {
+        msg = T{};
+        memcpy(&msg, payload, len < sizeof(T) ? len : sizeof(T));
+    }
+}
+
+/**
+ * @brief 编译期生成的消息分发表，以消息ID为下标直接跳转到处理函数
+ *
+ * @param Handler 处理者，需要为每种消息提供 void onMsg(const T&)
+ * @param Msgs 注册的消息结构体
+ */
+template <class Handler, class... Msgs>
+class MsgDispatch {
+    static_assert(PROTOCOL::uniqueId<Msgs...>(), "duplicate message ID");
+
+    public:
+        using Fn = void (*)(Handler&, const uint8_t*, size_t);
+
+        /**
+         * @brief 分发一个已通过校验的帧负载
+         *
+         * @return 消息ID已注册返回true
+         */
+        static bool dispatch(Handler& handler, uint8_t id, const uint8_t* payload, size_t len) {
+            Fn fn = table[id];
+            if (!fn) return false;
+            fn(handler, payload, len);
+            return true;
+        }
+
+        // 消息的可靠序号，非可靠消息或未注册的ID返回0
+        static uint16_t seq(uint8_t id, const uint8_t* payload, size_t len) {
+            return PROTOCOL::readSeq(payload, len, seqTable[id]);
+        }
+
+    private:
+        template <class T>
+        static void _call(Handler& handler, const uint8_t* payload, size_t len) {
+            T msg;
+            PROTOCOL::decode(payload, len, msg);
+            handler.onMsg(msg);
+        }
+
+        static constexpr std::array<Fn, 256> _makeTable() {
+            std::array<Fn, 256> t = {};
+            ((t[Msgs::ID] = &_call<Msgs>), ...);
+            return t;
+        }
+
+        static constexpr std::array<int16_t, 256> _makeSeqTable() {
+            std::array<int16_t, 256> t = {};
+            for (int16_t& off : t) off = -1;
+            ((t[Msgs::ID] = PROTOCOL::seqOffset<Msgs>()), ...);
+            return t;
+        }
+
+        static constexpr std::array<Fn, 256> table = _makeTable();
+        static constexpr std::array<int16_t, 256> seqTable = _makeSeqTable(); // 可靠序号偏移，-1为非可靠消息
+};
+
+#endif
@@ -0,0 +1,67 @@
+#include "still.hpp"
+
+StillDetector::StillDetector(double gyroVarTh, double accelVarTh) :
+    m_gyroVarTh(gyroVarTh),
+    m_accelVarTh(accelVarTh),
+    still(false) {
+}
+
+StillDetector::~StillDetector() {
+}
+
+/**
+ * @brief 压入一组采样并更新静止判定，窗口未满时始终判定为非静止
+ *
+ * @param gyroData 陀螺仪数据（未去零偏）
+ * @param accelData 加速度计数据
+ *
+ * @return 当前窗口是否处于静止
+ */
+bool StillDetector::update(const Vec3lf& gyroData, const Vec3lf& accelData) {
+    gyroNorm.push(sqrt(gyroData.x * gyroData.x + gyroData.y * gyroData.y + gyroData.z * gyroData.z));
+    accelNorm.push(sqrt(accelData.x * accelData.x + accelData.y * accelData.y + accelData.z * accelData.z));
+    gyroX.push(gyroData.x);
+    gyroY.push(gyroData.y);
+    gyroZ.push(gyroData.z);
+
+    if (!gyroNorm.full()) {
+        still = false;
+        return still;
+    }
+
+    double accelMean = accelNorm.mean();
+    if (accelMean <= 0.0) { // 加速度计无数据
+        still = false;
+        return still;
+    }
+
+    still = gyroNorm.var() < m_gyroVarTh && accelNorm.var() / (accelMean * accelMean) < m_accelVarTh;
+    return still;
+}
+
+bool StillDetector::isStill() const {
+    return still;
+}
+
+/**
+ * @brief 窗口内陀螺仪三轴均值，静止时即为零偏观测值
+ */
+Vec3lf StillDetector::gyroMean() const {
+    Vec3lf mean;
+    mean.x = gyroX.mean();
+    mean.y = gyroY.mean();
+    mean.z = gyroZ.mean();
+    return mean;
+}
+
+/**
+ * @brief 清空窗口，重新开始检测
+ */
+void StillDetector::reset() {
+    gyroNorm.reset();
+    accelNorm.reset();
+    gyroX.reset();
+    gyroY.reset();
+    gyroZ.reset();
+    still = false;
+}
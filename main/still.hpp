@@ -0,0 +1,83 @@
+#ifndef STILL_HPP
+#define STILL_HPP
+
+#include <cmath>
+#include <cstddef>
+#include "struct.hpp"
+
+/**
+ * @brief 滑动窗口统计，增量维护窗口内的和与平方和，每个采样O(1)
+ *
+ * @param N 窗口长度
+ */
+template <size_t N>
+class SlidingWindow {
+    public:
+        // 压入一个新采样，窗口满时挤出最旧的采样
+        void push(float x) {
+            if (cnt == N) {
+                float old = buf[pos];
+                sum -= old;
+                sumSq -= (double)old * old;
+            }
+            else {
+                cnt++;
+            }
+            buf[pos] = x;
+            sum += x;
+            sumSq += (double)x * x;
+            pos = (pos + 1) % N;
+        }
+
+        void reset() {
+            pos = 0;
+            cnt = 0;
+            sum = 0.0;
+            sumSq = 0.0;
+        }
+
+        bool full() const { return cnt == N; }
+        double mean() const { return cnt ? sum / cnt : 0.0; }
+        double var() const { // 总体方差，浮点误差可能导致略小于0，这里截断
+            if (!cnt) return 0.0;
+            double m = sum / cnt;
+            double v = sumSq / cnt - m * m;
+            return v > 0.0 ? v : 0.0;
+        }
+
+    private:
+        float buf[N] = {};
+        size_t pos = 0;
+        size_t cnt = 0;
+        double sum = 0.0;
+        double sumSq = 0.0;
+};
+
+/**
+ * @brief 零速（静止）检测器，滑动窗口内陀螺仪模长方差和加速度计模长相对方差均低于阈值时判定为静止
+ *
+ * @param gyroVarTh 陀螺仪模长方差阈值，单位与传入的陀螺仪数据一致（默认(°/s)^2）
+ * @param accelVarTh 加速度计模长相对方差阈值（方差/均值^2），与加速度计单位无关
+ *
+ * @note 窗口内同时维护陀螺仪三轴均值，静止时可直接作为陀螺仪零偏的观测
+ */
+class StillDetector {
+    public:
+        static constexpr size_t WINDOW = 128; // 滑动窗口长度，1kHz下约128ms
+
+        StillDetector(double gyroVarTh = 0.25, double accelVarTh = 1e-4);
+        ~StillDetector();
+
+        bool update(const Vec3lf& gyroData, const Vec3lf& accelData); // 更新一次采样，返回是否静止
+        bool isStill() const; // 最近一次更新的判定结果
+        Vec3lf gyroMean() const; // 窗口内陀螺仪三轴均值
+        void reset(); // 清空窗口
+
+    private:
+        double m_gyroVarTh, m_accelVarTh;
+        bool still;
+        SlidingWindow<WINDOW> gyroNorm, accelNorm; // 模长窗口
+        SlidingWindow<WINDOW> gyroX, gyroY, gyroZ; // 三轴窗口，用于求零偏
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "telemetry.hpp"
+#include <cmath>
+#include <cstring>
+
+AttiBatcher::AttiBatcher(uint8_t encoding, uint8_t maxSamples) :
+    m_maxSamples(maxSamples), m_used(0), m_prev{} {
+    m_batch.encoding = encoding;
+}
+
+AttiBatcher::~AttiBatcher() {
+}
+
+/**
+ * @brief 压入一个姿态采样
+ * 
+ * @param stamp 采样时间戳（us）
+ * @param atti 姿态角（°），范围-180~180
+ * 
+ * @return 放入当前帧返回true；帧已满、时间跨度超过65ms或差分超出int8范围时返回false，
+ *         此时应先发送当前帧再重新压入
+ */
+bool AttiBatcher::push(int64_t stamp, const Vec3lf& atti) {
+    if (m_batch.count >= m_maxSamples) return false;
+
+    int64_t dt = m_batch.count ? stamp - m_batch.stamp : 0;
+    if (dt < 0 || dt > UINT16_MAX) return false;
+
+    uint8_t sample[14];
+    size_t len;
+    uint16_t dt16 = dt;
+    memcpy(sample, &dt16, 2);
+
+    // 0.01°量化，±180°在int16范围内
+    int16_t q[3] = {
+        (int16_t)lround(atti.x * 100.0),
+        (int16_t)lround(atti.y * 100.0),
+        (int16_t)lround(atti.z * 100.0),
+    };
+
+    switch (m_batch.encoding) {
+        case ATTI_F32: {
+            float f[3] = {(float)atti.x, (float)atti.y, (float)atti.z};
+            memcpy(sample + 2, f, sizeof(f));
+            len = 14;
+            break;
+        }
+        case ATTI_F16: {
+            uint16_t h[3] = {floatToHalf(atti.x), floatToHalf(atti.y), floatToHalf(atti.z)};
+            memcpy(sample + 2, h, sizeof(h));
+            len = 8;
+            break;
+        }
+        case ATTI_I16:
+            memcpy(sample + 2, q, sizeof(q));
+            len = 8;
+            break;
+        default: // ATTI_DELTA
+            if (!m_batch.count) {
+                memcpy(sample + 2, q, sizeof(q));
+                len = 8;
+                break;
+            }
+            for (int i = 0; i < 3; i++) {
+                int d = q[i] - m_prev[i];
+                if (d > 18000) d -= 36000; // 跨±180°时走短路径
+                else if (d < -18000) d += 36000;
+                if (d < INT8_MIN || d > INT8_MAX) return false;
+                sample[2 + i] = (uint8_t)(int8_t)d;
+            }
+            len = 5;
+            break;
+    }
+
+    if (m_used + len > AttiBatch::MAX_DATA) return false;
+
+    if (!m_batch.count) m_batch.stamp = stamp;
+    memcpy(m_batch.data + m_used, sample, len);
+    m_used += len;
+    m_batch.count++;
+    memcpy(m_prev, q, sizeof(q));
+    return true;
+}
+
+bool AttiBatcher::full() const {
+    return m_batch.count >= m_maxSamples;
+}
+
+bool AttiBatcher::empty() const {
+    return m_batch.count == 0;
+}
+
+const AttiBatch& AttiBatcher::batch() const {
+    return m_batch;
+}
+
+/**
+ * @brief 清空当前帧，保留编码方式
+ */
+void AttiBatcher::reset() {
+    m_batch.count = 0;
+    m_batch.stamp = 0;
+    m_used = 0;
+}
+
+/**
+ * @brief float转半精度，溢出为无穷，过小时转为非规格化数或0
+ */
+uint16_t floatToHalf(float value) {
+    uint32_t f;
+    memcpy(&f, &value, 4);
+
+    uint16_t sign = (f >> 16) & 0x8000;
+    int32_t exp = ((f >> 23) & 0xFF) - 127 + 15;
+    uint32_t mant = f & 0x7FFFFF;
+
+    if (((f >> 23) & 0xFF) == 0xFF) // NaN和无穷
+        return sign | 0x7C00 | (mant ? 0x200 : 0);
+    if (exp >= 31) // 上溢
+        return sign | 0x7C00;
+    if (exp <= 0) { // 非规格化数
+        if (exp < -10) return sign;
+        mant |= 0x800000;
+        uint32_t shift = 14 - exp;
+        uint32_t half = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1);
+        uint32_t mid = 1u << (shift - 1);
+        if (rem > mid || (rem == mid && (half & 1))) half++;
+        return sign | half;
+    }
+
+    uint16_t half = sign | (exp << 10) | (mant >> 13);
+    uint32_t rem = mant & 0x1FFF;
+    if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) half++; // 进位可能进到指数，结果仍正确
+    return half;
+}
@@ -0,0 +1,37 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <cstdint>
+#include "struct.hpp"
+#include "uart_data_pack.hpp"
+
+/**
+ * @brief 批量姿态编码器，把连续的姿态采样按指定编码打包进AttiBatch
+ * 
+ * @param encoding 采样编码，见ATTI_ENC
+ * @param maxSamples 每帧最多的采样数，决定帧率与延迟的折中
+ * 
+ * @note 用法：push返回false时先发送batch()并reset()，再重新push当前采样
+ */
+class AttiBatcher {
+    public:
+        AttiBatcher(uint8_t encoding = ATTI_DELTA, uint8_t maxSamples = 32);
+        ~AttiBatcher();
+
+        bool push(int64_t stamp, const Vec3lf& atti); // 压入一个采样（°），放不下时返回false且不修改当前帧
+        bool full() const; // 已达到最大采样数
+        bool empty() const;
+        const AttiBatch& batch() const; // 当前帧
+        void reset(); // 清空当前帧，开始新的一帧
+
+    private:
+        AttiBatch m_batch;
+        uint8_t m_maxSamples;
+        size_t m_used; // 采样区已用字节
+        int16_t m_prev[3]; // 差分编码的上一个采样（0.01°）
+};
+
+// float转半精度（IEEE 754 binary16），就近舍入
+uint16_t floatToHalf(float value);
+
+#endif
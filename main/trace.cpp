@@ -0,0 +1,100 @@
+#include "trace.hpp"
+#include "datapack.hpp"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include <atomic>
+
+namespace {
+    /**
+     * 每个核心一个缓冲区：同一核心上的写入者在关中断期间写入，彼此不会交错；
+     * 读出者只有发送任务，因此是单生产者单消费者，无需加锁
+     */
+    struct TraceRing {
+        TraceRecord rec[TRACE::RING_SIZE];
+        std::atomic<uint32_t> head{0}; // 写下标，只由本核心写入
+        std::atomic<uint32_t> tail{0}; // 读下标，只由发送任务写入
+        std::atomic<uint32_t> dropped{0}; // 缓冲区满丢弃的条数
+    };
+
+    TraceRing rings[portNUM_PROCESSORS];
+
+    constexpr TickType_t DRAIN_PERIOD = pdMS_TO_TICKS(10); // 发送任务的唤醒周期
+
+    void drainTask(void* arg) {
+        COMM& comm = *static_cast<COMM*>(arg);
+        TraceBatch batch;
+        batch.cpuHz = esp_rom_get_cpu_ticks_per_us() * 1000000;
+        uint32_t lastDropped = 0;
+
+        while (true) {
+            vTaskDelay(DRAIN_PERIOD);
+
+            for (TraceRing& ring : rings) {
+                uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+                uint32_t head = ring.head.load(std::memory_order_acquire);
+
+                while (tail != head) {
+                    batch.count = 0;
+                    while (tail != head && batch.count < TraceBatch::MAX_RECORDS) {
+                        batch.records[batch.count++] = ring.rec[tail & (TRACE::RING_SIZE - 1)];
+                        tail++;
+                    }
+                    ring.tail.store(tail, std::memory_order_release); // 已拷出，归还空间
+
+                    uint32_t dropped = TRACE::dropped();
+                    batch.dropped = dropped - lastDropped;
+                    lastDropped = dropped;
+                    comm.sendMsg(batch);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief 写入一条日志，关中断期间完成，耗时为几十个周期
+ * 
+ * @note 关中断保证同核心的任务和中断不会交错写入，也不会在写入途中被迁移到另一核心
+ */
+void IRAM_ATTR TRACE::_write(uint16_t id, uint8_t nargs, const uint32_t* args) {
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+
+    uint8_t core = xPortGetCoreID();
+    TraceRing& ring = rings[core];
+    uint32_t head = ring.head.load(std::memory_order_relaxed);
+
+    if (head - ring.tail.load(std::memory_order_acquire) >= RING_SIZE) {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+        TraceRecord& rec = ring.rec[head & (RING_SIZE - 1)];
+        rec.cycle = esp_cpu_get_cycle_count();
+        rec.id = id;
+        rec.core = core;
+        rec.nargs = nargs;
+        memcpy(rec.args, args, sizeof(rec.args));
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+/**
+ * @brief 启动日志发送任务，把各核心缓冲区中的日志打包经COMM发出
+ * 
+ * @param comm 发送使用的通讯对象
+ * @param priority 任务优先级，应低于控制和采集任务
+ * @param core 绑定的核心
+ */
+bool TRACE::startDrain(COMM& comm, UBaseType_t priority, BaseType_t core) {
+    return SYSMON::createTask(drainTask, "trace", TRACE::DRAIN_TASK_STACK, &comm, priority, NULL, core);
+}
+
+/**
+ * @brief 缓冲区满丢弃的总条数
+ */
+uint32_t TRACE::dropped() {
+    uint32_t sum = 0;
+    for (TraceRing& ring : rings) sum += ring.dropped.load(std::memory_order_relaxed);
+    return sum;
+}
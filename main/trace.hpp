@@ -0,0 +1,62 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "freertos/FreeRTOS.h"
+#include "trace_ids.hpp"
+
+/**
+ * 二进制日志，替代热循环中的ESP_LOGI和Uart::printf
+ * 调用处只写入日志ID和原始参数到本核心的环形缓冲区，不做格式化；
+ * 低优先级任务把缓冲区打包成TraceBatch经COMM发出，上位机用 tools/trace_fmt.py 格式化
+ * 
+ * 用法：TRACE(ATTI, roll, pitch, yaw);  ID在trace_ids.hpp中定义
+ * 编译时定义 TRACE_ENABLE=0 可以完全去掉所有调用
+ */
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 1
+#endif
+
+class COMM;
+
+namespace TRACE {
+    constexpr size_t RING_SIZE = 256; // 每个核心的缓冲区条数，必须是2的幂
+    constexpr uint32_t DRAIN_TASK_STACK = 3072; // 发送任务栈大小
+
+    // 参数统一转为32位原始值，浮点按位存放，double降为float
+    inline uint32_t toWord(float value) {
+        uint32_t word;
+        memcpy(&word, &value, 4);
+        return word;
+    }
+    inline uint32_t toWord(double value) {
+        return toWord((float)value);
+    }
+    template <class T>
+    inline uint32_t toWord(T value) {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "trace argument must be integer or float");
+        return (uint32_t)value;
+    }
+
+    void _write(uint16_t id, uint8_t nargs, const uint32_t* args); // 写入本核心的缓冲区
+
+    template <class... Args>
+    inline void write(uint16_t id, Args... args) {
+        static_assert(sizeof...(Args) <= 4, "at most 4 trace arguments");
+        const uint32_t words[4] = {toWord(args)...};
+        _write(id, sizeof...(Args), words);
+    }
+
+    bool startDrain(COMM& comm, UBaseType_t priority, BaseType_t core = tskNO_AFFINITY); // 启动发送任务
+    uint32_t dropped(); // 缓冲区满丢弃的总条数
+}
+
+#if TRACE_ENABLE
+#define TRACE(name, ...) TRACE::write(TRACE_##name, ##__VA_ARGS__)
+#else
+#define TRACE(name, ...) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef TRACE_IDS_HPP
+#define TRACE_IDS_HPP
+
+#include <cstdint>
+
+/**
+ * 二进制日志的ID和格式串，ID按列表顺序从0分配，上位机 tools/trace_fmt.py 解析本文件格式化输出
+ * 格式串支持 %d %u %x %f 及其长度修饰，最多4个参数，新增条目只能追加在末尾
+ */
+#define TRACE_LIST(X) \
+    X(BOOT_FIRST_ATTI,  "first attitude at %u us") \
+    X(ATTI,             "atti %f %f %f") \
+    X(GYRO_BIAS,        "gyro bias %f %f %f still %d") \
+    X(CALI_LOADED,      "calibration loaded") \
+    X(CALI_FAIL,        "calibration invalid, recalibrate")
+
+#define TRACE_ENUM(name, fmt) TRACE_##name,
+enum TRACE_ID : uint16_t {
+    TRACE_LIST(TRACE_ENUM)
+    TRACE_ID_NUM
+};
+#undef TRACE_ENUM
+
+#endif
@@ -0,0 +1,434 @@
+#!/usr/bin/env python3
+"""
+COMM压测上位机
+
+向下位机发送带序号的 RoBoCmd，校验回传的 RoBoFeedBack 是否完整、有序、内容一致。
+下位机可以是linux目标上的 main/comm_host.cpp（伪终端），也可以是接在串口上的板子。
+同时应答下位机的 ClockPing，使反馈的时间戳对齐到本机 time.monotonic 时钟，
+统计指令到反馈的往返延迟、反馈的单向延迟，并打印下位机上报的各阶段延迟分布。
+
+用法:
+    python3 tools/comm_peer.py /dev/pts/3 --duration 10
+    python3 tools/comm_peer.py /dev/ttyUSB0 --baud 115200 --window 8
+    --noise 在帧之间插入随机字节，检验接收端的重新同步
+    --cobs 下位机以 COMM_FRAMING=1 编译时使用COBS帧格式
+    --bit-errors 按每字节的概率翻转指令流中的一个比特，统计线路噪声下每秒恢复的帧数
+    --reliable 可靠通道测试：先发送SeqReset清空下位机的序号窗口，指令带序号，按 --loss 的概率损坏帧，
+               根据反馈中的确认位图重发，检验每条指令恰好被处理一次
+"""
+import argparse
+import os
+import random
+import select
+import struct
+import sys
+import termios
+import time
+import tty
+
+HEADER = b"\x55\xAA"
+MSG_CMD = 0x01
+MSG_FEEDBACK = 0x02
+MSG_LATENCY = 0x05
+MSG_PING = 0x13
+MSG_PONG = 0x14
+MSG_SEQ_RESET = 0x15
+CMD = struct.Struct("<4f2BH")         # val1..val4 mode1 mode2 seq
+FEEDBACK = struct.Struct("<8f2BqBHI") # roll pitch yaw reserved1 altitudev vel_x vel_y vel_z status reserved2 stamp synced ackSeq ackBits
+ACK_BITS = 32                         # 确认位图覆盖的序号数，在途的可靠指令不能超过它
+PING = struct.Struct("<Iq")           # seq t1
+PONG = struct.Struct("<Iqqq")         # seq t1 t2 t3
+STAGE = struct.Struct("<5I")          # count p50 p90 p99 max
+LATENCY = struct.Struct("<15IIqf")    # rx proc tx rtt offset drift
+SEQ_MOD = 1 << 24                     # 序号放在float中，2^24以内可精确表示
+
+BAUDS = {b: getattr(termios, "B%d" % b) for b in (9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600)
+         if hasattr(termios, "B%d" % b)}
+
+
+def crc16(data):
+    """CRC-16/MODBUS，与固件 main/crc16.hpp 一致"""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+COBS = False  # 帧格式，由 --cobs 设置
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code = 0
+    for b in data:
+        if b == 0 or len(out) - code == 0xFF:
+            out[code] = len(out) - code
+            code = len(out)
+            out.append(0)
+            if b == 0:
+                continue
+        out.append(b)
+    out[code] = len(out) - code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode(msg_id, payload):
+    frame = HEADER + bytes([msg_id, len(payload)]) + payload
+    crc = crc16(frame)
+    frame += bytes([crc & 0xFF, crc >> 8])
+    if COBS:
+        return cobs_encode(frame[2:]) + b"\x00"  # 帧体与帧头格式相同，去掉0x55 0xAA
+    return frame
+
+
+class Parser:
+    """与固件 COMM::_nextFrame 相同的解析：找帧头、等整帧、校验失败跳过一个字节"""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.crc_errors = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(HEADER)
+            if start < 0:
+                del self.buf[:-1]
+                return
+            del self.buf[:start]
+            if len(self.buf) < 4:
+                return
+            length = self.buf[3]
+            if len(self.buf) < 6 + length:
+                return
+            frame = bytes(self.buf[:4 + length])
+            if crc16(frame) != (self.buf[4 + length] | self.buf[5 + length] << 8):
+                self.crc_errors += 1
+                del self.buf[:1]
+                continue
+            del self.buf[:6 + length]
+            yield frame[2], frame[4:]
+
+
+def now_us():
+    return time.monotonic_ns() // 1000
+
+
+def percentile(values, p):
+    if not values:
+        return 0
+    values = sorted(values)
+    return values[min(int(p * len(values)), len(values) - 1)]
+
+
+def write_all(fd, data):
+    view = memoryview(data)
+    while view:
+        try:
+            n = os.write(fd, view)
+            view = view[n:]
+        except BlockingIOError:
+            select.select([], [fd], [], 0.1)
+
+
+class CobsParser:
+    """与固件COBS格式的 COMM::_nextFrame 相同：按0x00切分、解码、校验"""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.crc_errors = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            end = self.buf.find(0)
+            if end < 0:
+                return
+            body = cobs_decode(bytes(self.buf[:end]))
+            del self.buf[:end + 1]
+            if not end:
+                continue
+            if body is None or len(body) < 4 or len(body) != 4 + body[1]:
+                self.crc_errors += 1
+                continue
+            frame = HEADER + body[:-2]
+            if crc16(frame) != (body[-2] | body[-1] << 8):
+                self.crc_errors += 1
+                continue
+            yield body[0], body[2:-2]
+
+
+def make_parser():
+    return CobsParser() if COBS else Parser()
+
+
+def flip_bits(data, rng, p):
+    """按每字节概率p翻转一个比特，模拟线路噪声"""
+    if not p:
+        return data
+    data = bytearray(data)
+    for i in range(len(data)):
+        if rng.random() < p:
+            data[i] ^= 1 << rng.randrange(8)
+    return bytes(data)
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+    tty.setraw(fd)
+    if baud in BAUDS:
+        attr = termios.tcgetattr(fd)
+        attr[4] = attr[5] = BAUDS[baud]
+        termios.tcsetattr(fd, termios.TCSANOW, attr)
+    return fd
+
+
+def handle_link(fd, msg_id, payload, t_recv):
+    """应答时钟同步、打印下位机的延迟统计，已处理返回True"""
+    if msg_id == MSG_PING and len(payload) >= PING.size:
+        ping_seq, t1 = PING.unpack_from(payload)
+        write_all(fd, encode(MSG_PONG, PONG.pack(ping_seq, t1, t_recv, now_us())))
+        return True
+    if msg_id == MSG_LATENCY and len(payload) >= LATENCY.size:
+        v = LATENCY.unpack_from(payload)
+        print("  device p50/p99/max us  rx %d/%d/%d  proc %d/%d/%d  tx %d/%d/%d  rtt %d  drift %.1f ppm" % (
+            v[1], v[3], v[4], v[6], v[8], v[9], v[11], v[13], v[14], v[15], v[17]))
+        return True
+    return False
+
+
+def receive(fd, rx, timeout):
+    """等待并解析收到的帧，返回 (收到时刻, [(id, payload)])"""
+    ready, _, _ = select.select([fd], [], [], timeout)
+    if not ready:
+        return None, []
+    try:
+        data = os.read(fd, 65536)
+    except BlockingIOError:
+        data = b""
+    return now_us(), list(rx.feed(data))
+
+
+def run_load(fd, opt):
+    """压测：窗口内尽量多地发送，校验回传完整、有序、内容一致"""
+    rx = make_parser()
+    rng = random.Random(1)
+
+    sent = received = mismatch = lost = 0
+    next_seq = expect_seq = 0
+    pending = {}  # 已发出未回传的 seq -> ((mode1, mode2), 发送时刻)
+    rtts = []  # 指令到反馈的往返（us）
+    one_way = []  # 反馈时间戳到收到的单向延迟（us），仅已同步的反馈
+    start = last_report = time.monotonic()
+    last_received = 0
+
+    while not opt.duration or time.monotonic() - start < opt.duration:
+        # 在窗口内尽量多地发送
+        out = bytearray()
+        while len(pending) < opt.window:
+            seq = next_seq
+            mode = (seq & 0xFF, (seq >> 8) & 0xFF)
+            out += encode(MSG_CMD, CMD.pack(float(seq), -float(seq), seq * 0.5, 1.0, *mode, 0))
+            if opt.noise and rng.random() < opt.noise:
+                out += bytes(rng.randrange(256) for _ in range(rng.randrange(1, 8)))
+            pending[seq] = (mode, None)
+            next_seq = (next_seq + 1) % SEQ_MOD
+            sent += 1
+        t_send = now_us()
+        for seq in pending:
+            if pending[seq][1] is None:
+                pending[seq] = (pending[seq][0], t_send)
+        write_all(fd, flip_bits(out, rng, opt.bit_errors))
+
+        # 接收并校验回传
+        t_recv, msgs = receive(fd, rx, 0.05)
+        for msg_id, payload in msgs:
+            if handle_link(fd, msg_id, payload, t_recv):
+                continue
+            if msg_id != MSG_FEEDBACK or len(payload) < FEEDBACK.size:
+                continue
+            v = FEEDBACK.unpack_from(payload)
+            if v[0] < 0:  # 心跳
+                continue
+            seq = int(v[0])
+            # 回传按发送顺序到达，中间跳过的序号视为丢失
+            while expect_seq != seq and expect_seq in pending:
+                del pending[expect_seq]
+                expect_seq = (expect_seq + 1) % SEQ_MOD
+                lost += 1
+            entry = pending.pop(seq, None)
+            if entry is None or v[1] != -float(seq) or v[2] != seq * 0.5 or (v[8], v[9]) != entry[0]:
+                mismatch += 1
+            else:
+                rtts.append(t_recv - entry[1])
+            if v[11]:
+                one_way.append(t_recv - v[10])
+            expect_seq = (seq + 1) % SEQ_MOD
+            received += 1
+        if t_recv is None and len(pending) >= opt.window:
+            # 窗口已满且超时无回传，认为窗口内全部丢失
+            lost += len(pending)
+            pending.clear()
+            expect_seq = next_seq
+
+        now = time.monotonic()
+        if now - last_report >= 1.0:
+            print("sent %d  received %d (%d/s)  lost %d  mismatch %d  crc errors %d" % (
+                sent, received, (received - last_received) / (now - last_report), lost, mismatch, rx.crc_errors))
+            print("  cmd->feedback p50 %d p99 %d us  feedback one-way p50 %d us (%d synced)" % (
+                percentile(rtts, 0.5), percentile(rtts, 0.99), percentile(one_way, 0.5), len(one_way)))
+            rtts.clear()
+            one_way.clear()
+            sys.stdout.flush()
+            last_report, last_received = now, received
+
+    print("total: sent %d  received %d  lost %d  mismatch %d  crc errors %d" % (
+        sent, received, lost, mismatch, rx.crc_errors))
+    return mismatch == 0 and rx.crc_errors == 0
+
+
+def reset_seq(fd, rx, opt):
+    """重发SeqReset直到反馈中ackSeq为0，此后下位机不会把本次的序号当作上次运行的重发"""
+    deadline = time.monotonic() + 2.0
+    next_send = 0.0
+    while time.monotonic() < deadline:
+        now = time.monotonic()
+        if now >= next_send:
+            write_all(fd, encode(MSG_SEQ_RESET, b"\x00"))
+            next_send = now + opt.retx_timeout
+        t_recv, msgs = receive(fd, rx, 0.005)
+        for msg_id, payload in msgs:
+            if handle_link(fd, msg_id, payload, t_recv):
+                continue
+            if msg_id == MSG_FEEDBACK and len(payload) >= FEEDBACK.size and FEEDBACK.unpack_from(payload)[12] == 0:
+                return True
+    return False
+
+
+def run_reliable(fd, opt):
+    """可靠通道：按确认位图有限次重发，检验每条送达的指令恰好被处理一次"""
+    rx = make_parser()
+    rng = random.Random(2)
+    if not reset_seq(fd, rx, opt):
+        print("no feedback with ackSeq 0 after SeqReset")
+        return False
+
+    def damage(frame):
+        if rng.random() >= opt.loss:
+            return frame
+        frame = bytearray(frame)
+        frame[4 + rng.randrange(CMD.size)] ^= 0xFF  # 损坏负载，下位机校验失败
+        return bytes(frame)
+
+    next_seq = 1
+    index = 0
+    outstanding = {}  # seq -> [帧, 上次发送时刻, 发送次数, 指令编号]
+    echoes = {}  # 指令编号 -> 回传次数
+    acked = set()  # 已确认的指令编号
+    sent = retransmits = failed = 0
+    start = last_report = time.monotonic()
+    window = min(opt.window, ACK_BITS)
+
+    while True:
+        now = time.monotonic()
+        sending = not opt.duration or now - start < opt.duration
+        if not sending and (not outstanding or now - start > opt.duration + 5):
+            break
+
+        out = bytearray()
+        # 最早未确认的序号与新序号之差也不能超过位图范围，否则它的重发会被下位机当作过期丢弃
+        while sending and len(outstanding) < window and (
+                not outstanding or (next_seq - next(iter(outstanding))) % 0xFFFF < window):
+            seq = next_seq
+            next_seq = next_seq % 0xFFFF + 1  # 0表示普通指令，不使用
+            frame = encode(MSG_CMD, CMD.pack(float(index), -float(index), index * 0.5, 1.0, index & 0xFF, 1, seq))
+            outstanding[seq] = [frame, now, 1, index]
+            echoes[index] = 0
+            out += damage(frame)
+            index = (index + 1) % SEQ_MOD
+            sent += 1
+        for seq, entry in list(outstanding.items()):
+            if now - entry[1] < opt.retx_timeout:
+                continue
+            if entry[2] >= opt.max_tries:  # 重发次数用尽，放弃
+                del outstanding[seq]
+                failed += 1
+                continue
+            entry[1] = now
+            entry[2] += 1
+            retransmits += 1
+            out += damage(entry[0])
+        write_all(fd, out)
+
+        t_recv, msgs = receive(fd, rx, 0.005)
+        for msg_id, payload in msgs:
+            if handle_link(fd, msg_id, payload, t_recv):
+                continue
+            if msg_id != MSG_FEEDBACK or len(payload) < FEEDBACK.size:
+                continue
+            v = FEEDBACK.unpack_from(payload)
+            if v[0] >= 0 and int(v[0]) in echoes:
+                echoes[int(v[0])] += 1
+            ack_seq, ack_bits = v[12], v[13]
+            if not ack_seq:
+                continue
+            seqs = [ack_seq] + [(ack_seq - 1 - i) & 0xFFFF for i in range(ACK_BITS) if ack_bits >> i & 1]
+            for seq in seqs:
+                entry = outstanding.pop(seq, None)
+                if entry:
+                    acked.add(entry[3])
+
+        if now - last_report >= 1.0:
+            print("sent %d  acked %d  retransmits %d  failed %d  outstanding %d" % (
+                sent, len(acked), retransmits, failed, len(outstanding)))
+            sys.stdout.flush()
+            last_report = now
+
+    duplicated = sum(1 for c in echoes.values() if c > 1)
+    missing = sum(1 for i in acked if echoes[i] == 0)
+    print("total: sent %d  acked %d  retransmits %d (%.2f per cmd)  failed %d  duplicated %d  acked without echo %d" % (
+        sent, len(acked), retransmits, retransmits / max(sent, 1), failed, duplicated, missing))
+    return duplicated == 0 and missing == 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="COMM load test peer")
+    parser.add_argument("port", help="pty or serial port of the device")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds, 0 for endless")
+    parser.add_argument("--window", type=int, default=16, help="max commands in flight, keep replies within the 1KB TX buffer")
+    parser.add_argument("--noise", type=float, default=0.0, help="probability of random bytes between frames")
+    parser.add_argument("--cobs", action="store_true", help="device built with COMM_FRAMING=1")
+    parser.add_argument("--bit-errors", type=float, default=0.0, help="per-byte probability of a bit flip in the command stream")
+    parser.add_argument("--reliable", action="store_true", help="test the reliable channel instead of raw load")
+    parser.add_argument("--loss", type=float, default=0.1, help="probability of damaging a reliable frame")
+    parser.add_argument("--retx-timeout", type=float, default=0.02, help="seconds before resending an unacked command")
+    parser.add_argument("--max-tries", type=int, default=5, help="give up after this many sends")
+    opt = parser.parse_args()
+
+    global COBS
+    COBS = opt.cobs
+    fd = open_port(opt.port, opt.baud)
+    ok = run_reliable(fd, opt) if opt.reliable else run_load(fd, opt)
+    os.close(fd)
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+只读配置区生成工具
+
+把JSON描述的表打包为 components/interface/config_blob.hpp 定义的配置区格式，
+烧录到config分区后固件经mmap以const结构体直接访问，启动时不解析、不拷贝。
+
+JSON示例:
+    {
+      "imu_cali":  {"gyroBias": [0.1, -0.2, 0.05], "accelBias": [12, -30, 40], "accelGain": [8190, 8195, 8188]},
+      "gyro_temp": {"temp": [-10, 25, 60], "bias": [[0.2, 0.1, 0.0], [0.0, 0.0, 0.0], [-0.3, 0.1, 0.2]]},
+      "filter":    {"sections": [[0.0675, 0.1349, 0.0675, -1.1430, 0.4128]]}
+    }
+
+用法:
+    python3 tools/config_gen.py config.json -o config.bin
+    parttool.py write_partition --partition-name config --input config.bin
+    python3 tools/config_gen.py --dump config.bin
+"""
+import argparse
+import json
+import struct
+import sys
+import zlib
+
+MAGIC = 0x42474643   # "CFGB"
+FORMAT = 1
+HEAD = struct.Struct("<IHHII")   # magic format count size crc
+ENTRY = struct.Struct("<HHII")   # id version offset len
+ALIGN = 8
+PARTITION_SIZE = 0x10000         # partitions.csv中config分区的大小
+
+
+def pack_imu_cali(t):
+    """ImuCali: Vec3lf gyroBias | Vec3i accelBias | 4字节填充 | Vec3lf accelGain"""
+    return struct.pack("<3d3i4x3d", *t["gyroBias"], *t["accelBias"], *t["accelGain"])
+
+
+def pack_gyro_temp(t):
+    """GyroTempCurve: count reserved | float temp[8] | float bias[8][3]，温度升序"""
+    points = sorted(zip(t["temp"], t["bias"]))
+    if not 0 < len(points) <= 8:
+        raise ValueError("gyro_temp needs 1..8 points")
+    temp = [p[0] for p in points] + [0.0] * (8 - len(points))
+    bias = [v for p in points for v in p[1]] + [0.0] * 3 * (8 - len(points))
+    return struct.pack("<II8f24f", len(points), 0, *temp, *bias)
+
+
+def pack_filter(t):
+    """BiquadCoeffs: count reserved | float sos[4][5]，每节 b0 b1 b2 a1 a2"""
+    sections = t["sections"]
+    if not 0 < len(sections) <= 4 or any(len(s) != 5 for s in sections):
+        raise ValueError("filter needs 1..4 sections of 5 coefficients")
+    sos = [v for s in sections for v in s] + [0.0] * 5 * (4 - len(sections))
+    return struct.pack("<II20f", len(sections), 0, *sos)
+
+
+# 名称: (表ID, 版本, 打包函数, 结构体长度)，与config_blob.hpp中的CONFIG_ID和版本号一致
+TABLES = {
+    "imu_cali":  (1, 1, pack_imu_cali, 64),
+    "gyro_temp": (2, 1, pack_gyro_temp, 136),
+    "filter":    (3, 1, pack_filter, 88),
+}
+
+
+def build(desc):
+    names = [n for n in desc if not n.startswith("_")]
+    for n in names:
+        if n not in TABLES:
+            raise ValueError("unknown table %s" % n)
+
+    offset = HEAD.size + len(names) * ENTRY.size
+    entries = b""
+    data = b""
+    for n in names:
+        table_id, version, pack, size = TABLES[n]
+        blob = pack(desc[n])
+        assert len(blob) == size, n
+        pad = -(offset + len(data)) % ALIGN
+        data += b"\x00" * pad
+        entries += ENTRY.pack(table_id, version, offset + len(data), len(blob))
+        data += blob
+
+    body = entries + data
+    size = HEAD.size + len(body)
+    if size > PARTITION_SIZE:
+        raise ValueError("config too large: %d bytes" % size)
+    return HEAD.pack(MAGIC, FORMAT, len(names), size, zlib.crc32(body)) + body
+
+
+def dump(blob):
+    magic, fmt, count, size, crc = HEAD.unpack_from(blob)
+    ok = magic == MAGIC and fmt == FORMAT and size <= len(blob) and zlib.crc32(blob[HEAD.size:size]) == crc
+    print("format %d  %d tables  %d bytes  %s" % (fmt, count, size, "ok" if ok else "INVALID"))
+    names = {v[0]: k for k, v in TABLES.items()}
+    for i in range(count):
+        table_id, version, off, length = ENTRY.unpack_from(blob, HEAD.size + i * ENTRY.size)
+        print("  id %d %-10s v%d  offset %d  len %d" % (table_id, names.get(table_id, "?"), version, off, length))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("input", help="JSON描述，--dump时为配置区文件")
+    ap.add_argument("-o", "--output", default="config.bin")
+    ap.add_argument("--dump", action="store_true", help="打印已有配置区的目录")
+    opt = ap.parse_args()
+
+    if opt.dump:
+        with open(opt.input, "rb") as f:
+            dump(f.read())
+        return
+
+    with open(opt.input, encoding="utf-8") as f:
+        blob = build(json.load(f))
+    with open(opt.output, "wb") as f:
+        f.write(blob)
+    dump(blob)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
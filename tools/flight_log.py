@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""
+黑匣子回放工具
+
+向下位机发送 LogDumpReq(0x07)，接收 LogChunk(0x08) 中的记录（main/flight_log.hpp），
+按时间顺序写成CSV，检查序号连续以发现回放中丢失的帧。
+
+用法:
+    python3 tools/flight_log.py /dev/ttyUSB0 --baud 115200 -o flight.csv
+    固件以 COMM_FRAMING=1 编译时加 --cobs
+"""
+import argparse
+import os
+import select
+import struct
+import sys
+
+import comm_peer
+
+MSG_LOG_REQ = 0x07
+MSG_LOG_CHUNK = 0x08
+CHUNK_HEAD = struct.Struct("<IBB")    # index done count
+RECORD = struct.Struct("<I3f3h3hHH")  # stamp atti[3] gyro[3] accel[3] flags crc
+GYRO_SCALE = 1.0 / 16                 # 角速度量化单位（°/s）
+COLUMNS = "stamp_us,roll,pitch,yaw,gyro_x,gyro_y,gyro_z,accel_x,accel_y,accel_z,still,mag_valid"
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port", help="串口或伪终端路径")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--cobs", action="store_true", help="COBS帧格式")
+    ap.add_argument("-o", "--output", default="-", help="CSV输出文件，默认标准输出")
+    ap.add_argument("--timeout", type=float, default=5.0, help="超过该时间（s）没有收到记录即结束")
+    opt = ap.parse_args()
+
+    comm_peer.COBS = opt.cobs
+    fd = comm_peer.open_port(opt.port, opt.baud)
+    parser = comm_peer.make_parser()
+    comm_peer.write_all(fd, comm_peer.encode(MSG_LOG_REQ, b"\x00"))
+
+    out = sys.stdout if opt.output == "-" else open(opt.output, "w")
+    out.write(COLUMNS + "\n")
+    expect = 0
+    records = 0
+    lost = 0
+    done = False
+    while not done:
+        ready, _, _ = select.select([fd], [], [], opt.timeout)
+        if not ready:
+            print("timeout, dump incomplete", file=sys.stderr)
+            break
+        for msg_id, payload in parser.feed(os.read(fd, 4096)):
+            if msg_id != MSG_LOG_CHUNK or len(payload) < CHUNK_HEAD.size:
+                continue
+            index, done, count = CHUNK_HEAD.unpack_from(payload)
+            if index != expect:
+                lost += index - expect
+            expect = index + count
+            for i in range(count):
+                off = CHUNK_HEAD.size + i * RECORD.size
+                if off + RECORD.size > len(payload):
+                    break
+                r = RECORD.unpack_from(payload, off)
+                gyro = ["%.4f" % (g * GYRO_SCALE) for g in r[4:7]]
+                out.write(",".join([str(r[0])] + ["%.3f" % a for a in r[1:4]] + gyro +
+                                   [str(a) for a in r[7:10]] + [str(r[10] & 1), str(r[10] >> 1 & 1)]) + "\n")
+                records += 1
+            if done:
+                break
+
+    if out is not sys.stdout:
+        out.close()
+    print("%d records, %d lost in transfer, %d crc errors" % (records, lost, parser.crc_errors), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
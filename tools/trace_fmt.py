@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""
+二进制日志格式化工具
+
+从串口或抓包文件读取COMM帧，解析 MSG_TRACE(0x04) 的 TraceBatch，
+按 main/trace_ids.hpp 中的格式串还原为文本；
+同时显示 MSG_PROBE(0x06) 的耗时探针统计，探针名取自 main/probe_ids.hpp。
+
+用法:
+    python3 tools/trace_fmt.py capture.bin
+    python3 tools/trace_fmt.py /dev/ttyUSB0 --baud 115200   (需要pyserial)
+    固件以 COMM_FRAMING=1 编译时加 --cobs
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+
+HEADER = b"\x55\xAA"
+MSG_TRACE = 0x04
+BATCH_HEAD = struct.Struct("<IHB")    # cpuHz dropped count
+RECORD = struct.Struct("<IHBB4I")     # cycle id core nargs args[4]
+MSG_PROBE = 0x06
+PROBE_HEAD = struct.Struct("<IB")     # cpuHz count
+PROBE_STAT = struct.Struct("<B5I")    # id count min p50 p99 max
+
+DEFAULT_IDS = os.path.join(os.path.dirname(__file__), "..", "main", "trace_ids.hpp")
+DEFAULT_PROBE_IDS = os.path.join(os.path.dirname(__file__), "..", "main", "probe_ids.hpp")
+
+
+def crc16(data):
+    """CRC-16/MODBUS，与固件 main/crc16.hpp 一致"""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def load_ids(path):
+    """按顺序解析 TRACE_LIST 中的 X(NAME, "fmt")，ID即序号"""
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+    return [(name, fmt) for name, fmt in re.findall(r'X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', text)]
+
+
+SPEC = re.compile(r"%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l|z)?([diuxXfeEgGc])")
+
+
+def format_record(fmt, args):
+    """把C格式串转为Python格式化，浮点参数按位还原"""
+    values = []
+    for i, m in enumerate(SPEC.finditer(fmt)):
+        word = args[i] if i < len(args) else 0
+        conv = m.group(1)
+        if conv in "feEgG":
+            values.append(struct.unpack("<f", struct.pack("<I", word))[0])
+        elif conv in "di":
+            values.append(word - (1 << 32) if word & 0x80000000 else word)
+        else:
+            values.append(word)
+    def to_py(m):
+        spec = re.sub(r"(hh|h|ll|l|z)(?=[diuxXfeEgGc]$)", "", m.group(0))
+        return spec[:-1] + "d" if spec.endswith("u") else spec
+    return SPEC.sub(to_py, fmt) % tuple(values)
+
+
+def print_probes(payload, names):
+    """耗时探针统计，周期换算为us"""
+    if len(payload) < PROBE_HEAD.size:
+        return
+    cpu_hz, count = PROBE_HEAD.unpack_from(payload)
+    scale = 1e6 / cpu_hz if cpu_hz else 1.0
+    print("--- probes (us)  %-20s %8s %9s %9s %9s %9s" % ("", "count", "min", "p50", "p99", "max"))
+    for i in range(count):
+        off = PROBE_HEAD.size + i * PROBE_STAT.size
+        if off + PROBE_STAT.size > len(payload):
+            break
+        pid, n, *stats = PROBE_STAT.unpack_from(payload, off)
+        name = names[pid][1] if pid < len(names) else "UNKNOWN_%d" % pid
+        print("    %-33s %8d %s" % (name, n, " ".join("%9.1f" % (v * scale) for v in stats)))
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def cobs_frames(stream, follow=False):
+    """COBS帧格式：按0x00切分，帧体为 id | len | payload | crc，CRC包含0x55 0xAA"""
+    buf = b""
+    while True:
+        chunk = stream.read(4096)
+        if not chunk:
+            if follow:
+                continue
+            return
+        buf += chunk
+        *parts, buf = buf.split(b"\x00")
+        for part in parts:
+            body = cobs_decode(part) if part else None
+            if not body or len(body) < 4 or len(body) != 4 + body[1]:
+                continue
+            if crc16(HEADER + body[:-2]) != (body[-2] | body[-1] << 8):
+                continue
+            yield body[0], body[2:-2]
+
+
+def frames(stream, follow=False):
+    """从字节流中提取通过校验的 (id, payload)，follow为True时读不到数据继续等待"""
+    buf = b""
+    while True:
+        chunk = stream.read(4096)
+        if not chunk:
+            if follow:
+                continue
+            return
+        buf += chunk
+        while True:
+            start = buf.find(HEADER)
+            if start < 0:
+                buf = buf[-1:]
+                break
+            buf = buf[start:]
+            if len(buf) < 4:
+                break
+            length = buf[3]
+            if len(buf) < 4 + length + 2:
+                break
+            frame = buf[:4 + length]
+            crc = buf[4 + length] | buf[5 + length] << 8
+            if crc16(frame) != crc:
+                buf = buf[1:]  # 假帧头，跳过继续找
+                continue
+            yield buf[2], frame[4:]
+            buf = buf[6 + length:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="format binary trace from COMM frames")
+    parser.add_argument("source", help="capture file or serial port")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--ids", default=DEFAULT_IDS, help="path of trace_ids.hpp")
+    parser.add_argument("--probe-ids", default=DEFAULT_PROBE_IDS, help="path of probe_ids.hpp")
+    parser.add_argument("--cobs", action="store_true", help="firmware built with COMM_FRAMING=1")
+    opt = parser.parse_args()
+
+    ids = load_ids(opt.ids)
+    probe_names = load_ids(opt.probe_ids)
+    follow = opt.source.startswith("/dev/") or opt.source.upper().startswith("COM")
+    if follow:
+        import serial
+        stream = serial.Serial(opt.source, opt.baud, timeout=0.1)
+    else:
+        stream = open(opt.source, "rb")
+
+    clock = {}  # 每个核心的 [上一周期计数, 累计周期]，周期计数器32位会回绕
+    for msg_id, payload in (cobs_frames if opt.cobs else frames)(stream, follow):
+        if msg_id == MSG_PROBE:
+            print_probes(payload, probe_names)
+            continue
+        if msg_id != MSG_TRACE or len(payload) < BATCH_HEAD.size:
+            continue
+        cpu_hz, dropped, count = BATCH_HEAD.unpack_from(payload)
+        if dropped:
+            print("--- %d records dropped ---" % dropped)
+        for i in range(count):
+            off = BATCH_HEAD.size + i * RECORD.size
+            if off + RECORD.size > len(payload):
+                break
+            cycle, rid, core, nargs, *args = RECORD.unpack_from(payload, off)
+            last = clock.setdefault(core, [cycle, 0])
+            last[1] += (cycle - last[0]) & 0xFFFFFFFF
+            last[0] = cycle
+            t = last[1] / cpu_hz if cpu_hz else 0.0
+            if rid < len(ids):
+                name, fmt = ids[rid]
+                text = format_record(fmt, args[:nargs])
+            else:
+                name, text = "UNKNOWN_%d" % rid, " ".join("%08x" % a for a in args[:nargs])
+            print("%10.6f [%d] %-16s %s" % (t, core, name, text))
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()